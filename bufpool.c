@@ -0,0 +1,98 @@
+/* DOCUMENTATION
+Discription : Pool of preallocated, page-aligned buffers shared by worker threads.
+A buffer is grown on demand and then kept, so repeated requests on images
+of similar size do not allocate or fault in fresh pages.*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bufpool.h"
+#include "types.h"
+
+// Function to allocate a page-aligned buffer and fault its pages in
+static char *alloc_aligned(size_t size)
+{
+    void *ptr;
+    long page=sysconf(_SC_PAGESIZE);
+    size=(size+page-1)/page*page; // Round up to whole pages
+    if(posix_memalign(&ptr,page,size)!=0)
+        return NULL;
+    memset(ptr,0,size); // Touch every page now instead of on first request
+    return ptr;
+}
+
+// Function to allocate count buffers of initial_size bytes each
+Status pool_init(BufferPool *pool, int count, size_t initial_size)
+{
+    pool->buffers=calloc(count,sizeof(PoolBuffer));
+    if(pool->buffers==NULL)
+        return e_failure;
+    pool->count=count;
+    for(int i=0;i<count;i++)
+    {
+        pool->buffers[i].data=alloc_aligned(initial_size);
+        if(pool->buffers[i].data==NULL)
+        {
+            pool_destroy(pool);
+            return e_failure;
+        }
+        pool->buffers[i].capacity=initial_size;
+    }
+    pthread_mutex_init(&pool->lock,NULL);
+    pthread_cond_init(&pool->available,NULL);
+    return e_success;
+}
+
+// Function to take a free buffer of at least size bytes from the pool
+PoolBuffer *pool_acquire(BufferPool *pool, size_t size)
+{
+    PoolBuffer *buf=NULL;
+    pthread_mutex_lock(&pool->lock);
+    while(buf==NULL)
+    {
+        for(int i=0;i<pool->count;i++) // Prefer a free buffer that is already big enough
+        {
+            if(pool->buffers[i].in_use)
+                continue;
+            if(buf==NULL || (buf->capacity<size && pool->buffers[i].capacity>buf->capacity))
+                buf=&pool->buffers[i];
+        }
+        if(buf==NULL)
+            pthread_cond_wait(&pool->available,&pool->lock); // All buffers busy
+    }
+    buf->in_use=1;
+    pthread_mutex_unlock(&pool->lock);
+
+    if(buf->capacity<size) // Grow the buffer, it stays this size afterwards
+    {
+        char *data=alloc_aligned(size);
+        if(data==NULL)
+        {
+            pool_release(pool,buf);
+            return NULL;
+        }
+        free(buf->data);
+        buf->data=data;
+        buf->capacity=size;
+    }
+    return buf;
+}
+
+// Function to give a buffer back to the pool
+void pool_release(BufferPool *pool, PoolBuffer *buf)
+{
+    pthread_mutex_lock(&pool->lock);
+    buf->in_use=0;
+    pthread_cond_signal(&pool->available);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Function to free all buffers of the pool
+void pool_destroy(BufferPool *pool)
+{
+    for(int i=0;i<pool->count;i++)
+        free(pool->buffers[i].data);
+    free(pool->buffers);
+    pool->buffers=NULL;
+    pool->count=0;
+}
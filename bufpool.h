@@ -0,0 +1,41 @@
+#ifndef BUFPOOL_H
+#define BUFPOOL_H
+
+#include <stddef.h>
+#include <pthread.h>
+#include "types.h"
+
+/*
+ * Pool of page-aligned buffers kept warm between requests.
+ * Buffers only grow, so a buffer that once held a large
+ * image is reused without allocating again.
+ */
+
+typedef struct _PoolBuffer
+{
+    char *data;
+    size_t capacity;
+    int in_use;
+} PoolBuffer;
+
+typedef struct _BufferPool
+{
+    PoolBuffer *buffers;
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t available;
+} BufferPool;
+
+/* Allocate count buffers of initial_size bytes each */
+Status pool_init(BufferPool *pool, int count, size_t initial_size);
+
+/* Take a free buffer holding at least size bytes, waits while all are in use */
+PoolBuffer *pool_acquire(BufferPool *pool, size_t size);
+
+/* Give a buffer back to the pool */
+void pool_release(BufferPool *pool, PoolBuffer *buf);
+
+/* Free all buffers of the pool */
+void pool_destroy(BufferPool *pool);
+
+#endif
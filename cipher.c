@@ -0,0 +1,126 @@
+/* DOCUMENTATION
+Discription : ChaCha20 (RFC 8439) keystream for encrypting the secret file data.
+Four consecutive blocks are computed together, one block per lane of
+128 bit vectors, so the keystream comes out 256 bytes at a time and is
+XORed into the data inside the embed/extract loops.*/
+#include <string.h>
+#include <sys/random.h>
+#include "cipher.h"
+#include "sha256.h"
+#include "types.h"
+
+typedef uint32_t u32x4 __attribute__((vector_size(16))); // One word of four blocks
+
+#define ROTL(v,n) (((v)<<(n))|((v)>>(32-(n))))
+#define QUARTER_ROUND(a,b,c,d) \
+    a+=b; d^=a; d=ROTL(d,16);  \
+    c+=d; b^=c; b=ROTL(b,12);  \
+    a+=b; d^=a; d=ROTL(d,8);   \
+    c+=d; b^=c; b=ROTL(b,7);
+
+// Function to compute the next four keystream blocks and advance the block counter
+static void chacha20_blocks(CipherStream *cs)
+{
+    u32x4 x[16],start[16];
+    for(int i=0;i<16;i++)
+        start[i]=(u32x4){cs->input[i],cs->input[i],cs->input[i],cs->input[i]};
+    start[12]+=(u32x4){0,1,2,3}; // Lane l computes block counter + l
+    memcpy(x,start,sizeof(x));
+
+    for(int i=0;i<10;i++) // 20 rounds
+    {
+        QUARTER_ROUND(x[0],x[4],x[8],x[12]);
+        QUARTER_ROUND(x[1],x[5],x[9],x[13]);
+        QUARTER_ROUND(x[2],x[6],x[10],x[14]);
+        QUARTER_ROUND(x[3],x[7],x[11],x[15]);
+        QUARTER_ROUND(x[0],x[5],x[10],x[15]);
+        QUARTER_ROUND(x[1],x[6],x[11],x[12]);
+        QUARTER_ROUND(x[2],x[7],x[8],x[13]);
+        QUARTER_ROUND(x[3],x[4],x[9],x[14]);
+    }
+    for(int i=0;i<16;i++)
+    {
+        x[i]+=start[i];
+        for(int l=0;l<4;l++) // Serialize little endian, block by block
+        {
+            unsigned char *out=cs->keystream+l*64+i*4;
+            out[0]=x[i][l];
+            out[1]=x[i][l]>>8;
+            out[2]=x[i][l]>>16;
+            out[3]=x[i][l]>>24;
+        }
+    }
+    cs->input[12]+=4;
+    cs->used=0;
+}
+
+// Function to load key, nonce and block counter into the ChaCha20 input block
+void cipher_init_key(CipherStream *cs, const unsigned char key[32], const unsigned char nonce[CIPHER_NONCE_SIZE], uint32_t counter)
+{
+    static const uint32_t sigma[4]={0x61707865,0x3320646e,0x79622d32,0x6b206574}; // "expand 32-byte k"
+    memcpy(cs->input,sigma,sizeof(sigma));
+    for(int i=0;i<8;i++)
+        cs->input[4+i]=key[4*i]|key[4*i+1]<<8|key[4*i+2]<<16|(uint32_t)key[4*i+3]<<24;
+    cs->input[12]=counter;
+    for(int i=0;i<3;i++)
+        cs->input[13+i]=nonce[4*i]|nonce[4*i+1]<<8|nonce[4*i+2]<<16|(uint32_t)nonce[4*i+3]<<24;
+    cs->used=CIPHER_BLOCK_SIZE; // Nothing generated yet
+}
+
+// Function to derive the key and the key check value from passphrase and salt
+static void cipher_derive_key(const char *passphrase, const unsigned char *salt, unsigned char key[32], unsigned char check[CIPHER_CHECK_SIZE])
+{
+    unsigned char digest[SHA256_DIGEST_SIZE];
+    pbkdf2_hmac_sha256(passphrase,strlen(passphrase),salt,CIPHER_SALT_SIZE,CIPHER_KDF_ITERATIONS,key,32);
+    sha256(key,32,digest); // Lets a wrong passphrase be detected without revealing the key
+    memcpy(check,digest,CIPHER_CHECK_SIZE);
+}
+
+// Function to pick a random salt and nonce and derive the key
+Status cipher_init_encrypt(CipherStream *cs, const char *passphrase, unsigned char params[CIPHER_HEADER_SIZE])
+{
+    unsigned char key[32];
+    if(getrandom(params,CIPHER_SALT_SIZE+CIPHER_NONCE_SIZE,0)!=CIPHER_SALT_SIZE+CIPHER_NONCE_SIZE)
+        return e_failure;
+    cipher_derive_key(passphrase,params,key,params+CIPHER_SALT_SIZE+CIPHER_NONCE_SIZE);
+    cipher_init_key(cs,key,params+CIPHER_SALT_SIZE,0);
+    memset(key,0,sizeof(key));
+    return e_success;
+}
+
+// Function to derive the key from the embedded salt and check it against the passphrase
+Status cipher_init_decrypt(CipherStream *cs, const char *passphrase, const unsigned char params[CIPHER_HEADER_SIZE])
+{
+    unsigned char key[32],check[CIPHER_CHECK_SIZE];
+    cipher_derive_key(passphrase,params,key,check);
+    if(memcmp(check,params+CIPHER_SALT_SIZE+CIPHER_NONCE_SIZE,CIPHER_CHECK_SIZE)!=0)
+    {
+        memset(key,0,sizeof(key));
+        return e_failure;
+    }
+    cipher_init_key(cs,key,params+CIPHER_SALT_SIZE,0);
+    memset(key,0,sizeof(key));
+    return e_success;
+}
+
+// Function to encrypt or decrypt size bytes in place
+void cipher_xor(CipherStream *cs, char *data, long size)
+{
+    while(size>0)
+    {
+        if(cs->used==CIPHER_BLOCK_SIZE)
+            chacha20_blocks(cs);
+        long n=CIPHER_BLOCK_SIZE-cs->used<size ? CIPHER_BLOCK_SIZE-cs->used : size;
+        for(long i=0;i<n;i++)
+            data[i]^=cs->keystream[cs->used+i];
+        cs->used+=n;
+        data+=n;
+        size-=n;
+    }
+}
+
+// Function to clear key material
+void cipher_wipe(CipherStream *cs)
+{
+    memset(cs,0,sizeof(*cs));
+}
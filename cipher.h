@@ -0,0 +1,44 @@
+#ifndef CIPHER_H
+#define CIPHER_H
+
+#include <stdint.h>
+#include "types.h"
+
+/*
+ * ChaCha20 stream encryption of the secret file data.
+ * The key is derived from a passphrase with PBKDF2-HMAC-SHA256
+ * and a random salt. Salt, nonce and a short key check value are
+ * embedded in front of the secret data, inside the Reed-Solomon
+ * codewords when ECC is used.
+ */
+
+#define CIPHER_SALT_SIZE 16
+#define CIPHER_NONCE_SIZE 12
+#define CIPHER_CHECK_SIZE 4
+#define CIPHER_HEADER_SIZE (CIPHER_SALT_SIZE + CIPHER_NONCE_SIZE + CIPHER_CHECK_SIZE)
+#define CIPHER_KDF_ITERATIONS 50000
+#define CIPHER_BLOCK_SIZE 256 // Four ChaCha20 blocks are generated at once
+
+typedef struct _CipherStream
+{
+    uint32_t input[16];                         // Constants, key, block counter, nonce
+    unsigned char keystream[CIPHER_BLOCK_SIZE]; // Keystream not used up yet
+    int used;
+} CipherStream;
+
+/* Pick a random salt and nonce and derive the key, params gets salt, nonce and key check */
+Status cipher_init_encrypt(CipherStream *cs, const char *passphrase, unsigned char params[CIPHER_HEADER_SIZE]);
+
+/* Derive the key from salt and nonce in params, fails when the key check does not match */
+Status cipher_init_decrypt(CipherStream *cs, const char *passphrase, const unsigned char params[CIPHER_HEADER_SIZE]);
+
+/* Load a raw key and nonce, the keystream starts at block counter */
+void cipher_init_key(CipherStream *cs, const unsigned char key[32], const unsigned char nonce[CIPHER_NONCE_SIZE], uint32_t counter);
+
+/* Encrypt or decrypt size bytes in place, continuing the keystream */
+void cipher_xor(CipherStream *cs, char *data, long size);
+
+/* Clear key material */
+void cipher_wipe(CipherStream *cs);
+
+#endif
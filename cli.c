@@ -0,0 +1,271 @@
+/* DOCUMENTATION
+Discription : Command line front end of the tool.
+Parses the mode and the options with getopt_long, long options have a short form.
+File names can be given with -i, -m and -o or positionally in the old order,
+so "-e beautiful.bmp secret.txt output.bmp" keeps working.
+Nothing here prompts or waits, the exit code tells scripts what happened.*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <getopt.h>
+#include "cli.h"
+#include "common.h"
+#include "ecc.h"
+
+int quiet_mode=0;
+
+static const struct option long_options[]=
+{
+    {"encode", no_argument, NULL, 'e'},
+    {"decode", no_argument, NULL, 'd'},
+    {"serve", no_argument, NULL, 's'},
+    {"update", no_argument, NULL, 'u'},
+    {"fanout", no_argument, NULL, 'f'},
+    {"apply", no_argument, NULL, 'a'},
+    {"input", required_argument, NULL, 'i'},
+    {"message", required_argument, NULL, 'm'},
+    {"output", required_argument, NULL, 'o'},
+    {"cover", required_argument, NULL, 'c'},
+    {"key", required_argument, NULL, 'k'},
+    {"ecc", optional_argument, NULL, 'r'},
+    {"direct", no_argument, NULL, 'D'},
+    {"jobs", required_argument, NULL, 'j'},
+    {"delta", no_argument, NULL, 'P'},
+    {"lsb-plane", no_argument, NULL, 'L'},
+    {"quiet", no_argument, NULL, 'q'},
+    {"stats", no_argument, NULL, 'S'},
+    {"help", no_argument, NULL, 'h'},
+    {NULL, 0, NULL, 0}
+};
+
+// Function to check that a string is a plain decimal number
+static int is_number(const char *str)
+{
+    if(str==NULL || *str=='\0')
+        return 0;
+    for(;*str;str++)
+        if(!isdigit((unsigned char)*str))
+            return 0;
+    return 1;
+}
+
+// Function to find the positional slots of a mode, -1 when the mode has no such file
+static int get_mode_slots(OperationType mode, int *secret_slot, int *output_slot)
+{
+    *secret_slot=-1;
+    *output_slot=-1;
+    switch(mode)
+    {
+        case e_encode: // cover secret [stego]
+            *secret_slot=1;
+            *output_slot=2;
+            return 3;
+        case e_decode: // stego [output]
+            *output_slot=1;
+            return 2;
+        case e_update: // stego secret [offset]
+            *secret_slot=1;
+            return 3;
+        case e_daemon: // socket [workers]
+            return 2;
+        case e_fanout: // cover, the secrets follow and -o names a directory
+            return 1;
+        case e_apply: // delta [stego], the cover is given with -c
+            *output_slot=1;
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+// Function to set the mode, only one mode may be given
+static int set_mode(CliInfo *cli, OperationType mode)
+{
+    if(cli->mode!=e_unsupported && cli->mode!=mode)
+    {
+        print_error("ERROR : ONLY ONE OF -e -d -s -u -f -a CAN BE GIVEN ...❌\n");
+        return EXIT_USAGE;
+    }
+    cli->mode=mode;
+    return EXIT_OK;
+}
+
+// Function to parse the command line
+int read_cli_args(int argc, char *argv[], CliInfo *cli)
+{
+    memset(cli,0,sizeof(*cli));
+    cli->mode=e_unsupported;
+    opterr=0; // Errors are reported below
+
+    int opt;
+    while((opt=getopt_long(argc,argv,":edsufai:m:o:c:k:r::Dj:PLqSh",long_options,NULL))!=-1)
+    {
+        int ret=EXIT_OK;
+        switch(opt)
+        {
+            case 'e': ret=set_mode(cli,e_encode); break;
+            case 'd': ret=set_mode(cli,e_decode); break;
+            case 's': ret=set_mode(cli,e_daemon); break;
+            case 'u': ret=set_mode(cli,e_update); break;
+            case 'f': ret=set_mode(cli,e_fanout); break;
+            case 'a': ret=set_mode(cli,e_apply); break;
+            case 'i': cli->input_fname=optarg; break;
+            case 'm': cli->secret_fname=optarg; break;
+            case 'o': cli->output_fname=optarg; break;
+            case 'c': cli->cover_fname=optarg; break;
+            case 'k': cli->passphrase=optarg; break;
+            case 'r': // Reed-Solomon ECC, the parity may also follow as the next argument
+                cli->ecc_parity=DEFAULT_RS_PARITY;
+                if(optarg==NULL && optind<argc && is_number(argv[optind]))
+                    optarg=argv[optind++];
+                if(optarg!=NULL)
+                    cli->ecc_parity=is_number(optarg) ? atoi(optarg) : 0;
+                if(cli->ecc_parity<2 || cli->ecc_parity>MAX_RS_PARITY)
+                {
+                    print_error(">>>>>>>>>>>>>>ECC parity should be 2 to %d ❌>>>>>>>>>>>>>>\n",MAX_RS_PARITY);
+                    return EXIT_USAGE;
+                }
+                break;
+            case 'D': cli->direct_io=1; break;
+            case 'j': // Number of encoding threads
+                cli->num_workers=is_number(optarg) ? atoi(optarg) : 0;
+                if(cli->num_workers<=0)
+                {
+                    print_error(">>>>>>>>>>>>>>Invalid number of jobs %s ❌>>>>>>>>>>>>>>\n",optarg);
+                    return EXIT_USAGE;
+                }
+                break;
+            case 'P': cli->delta_output=1; break;
+            case 'L': cli->delta_output=1; cli->delta_lsb_plane=1; break; // LSB plane implies a delta
+            case 'q': quiet_mode=1; break;
+            case 'S': cli->show_stats=1; break;
+            case 'h':
+                print_usage(stdout,argv[0]);
+                exit(EXIT_OK);
+            case ':':
+                print_error(">>>>>>>>>>>>>>Option %s needs a value ❌>>>>>>>>>>>>>>\n",argv[optind-1]);
+                return EXIT_USAGE;
+            default:
+                print_error(">>>>>>>>>>>>>>Unknown option %s ❌>>>>>>>>>>>>>>\n",argv[optind-1]);
+                return EXIT_USAGE;
+        }
+        if(ret!=EXIT_OK)
+            return ret;
+    }
+
+    int secret_slot,output_slot;
+    int num_slots=get_mode_slots(cli->mode,&secret_slot,&output_slot);
+    if(num_slots==0)
+    {
+        print_error("ERROR : NO MODE GIVEN, USE -e -d -s -u -f OR -a ...❌\n");
+        print_usage(stderr,argv[0]);
+        return EXIT_USAGE;
+    }
+    if((cli->secret_fname!=NULL && secret_slot<0) || (cli->output_fname!=NULL && output_slot<0 && cli->mode!=e_fanout))
+    {
+        print_error("ERROR : -m OR -o IS NOT USED BY THIS MODE ...❌\n");
+        return EXIT_USAGE;
+    }
+    if(cli->cover_fname!=NULL && cli->mode!=e_decode && cli->mode!=e_apply)
+    {
+        print_error("ERROR : -c IS ONLY USED BY -d AND -a ...❌\n");
+        return EXIT_USAGE;
+    }
+    if(cli->ecc_parity!=0 && cli->mode!=e_encode && cli->mode!=e_fanout)
+    {
+        print_error("ERROR : -r IS ONLY USED BY -e AND -f ...❌\n");
+        return EXIT_USAGE;
+    }
+    if(cli->passphrase!=NULL && cli->mode!=e_encode && cli->mode!=e_decode && cli->mode!=e_fanout)
+    {
+        print_error("ERROR : -k IS ONLY USED BY -e -d AND -f ...❌\n");
+        return EXIT_USAGE;
+    }
+    if(cli->direct_io && cli->mode!=e_encode)
+    {
+        print_error("ERROR : -D IS ONLY USED BY -e ...❌\n");
+        return EXIT_USAGE;
+    }
+    if(cli->delta_output && cli->mode!=e_encode)
+    {
+        print_error("ERROR : -P AND -L ARE ONLY USED BY -e ...❌\n");
+        return EXIT_USAGE;
+    }
+    if(cli->delta_output && cli->direct_io)
+    {
+        print_error("ERROR : -P AND -L CANNOT BE USED WITH -D ...❌\n");
+        return EXIT_USAGE;
+    }
+    if(cli->show_stats && cli->mode!=e_encode && cli->mode!=e_fanout)
+    {
+        print_error("ERROR : -S IS ONLY USED BY -e AND -f ...❌\n");
+        return EXIT_USAGE;
+    }
+    if(cli->num_workers!=0 && cli->mode!=e_fanout)
+    {
+        print_error("ERROR : -j IS ONLY USED BY -f ...❌\n");
+        return EXIT_USAGE;
+    }
+
+    // Named files take their slot, positional arguments fill the rest in order
+    cli->files[0]=cli->input_fname;
+    if(secret_slot>=0)
+        cli->files[secret_slot]=cli->secret_fname;
+    if(output_slot>=0)
+        cli->files[output_slot]=cli->output_fname;
+    for(int slot=0;optind<argc;slot++)
+    {
+        if(slot>=num_slots && cli->mode==e_fanout) // The rest are the secrets
+        {
+            cli->secret_fnames=argv+optind;
+            cli->num_secrets=argc-optind;
+            optind=argc;
+            break;
+        }
+        if(slot>=num_slots)
+        {
+            print_error("ERROR : TOO MANY ARGUMENTS, %s IS NOT EXPECTED ...❌\n",argv[optind]);
+            return EXIT_USAGE;
+        }
+        if(cli->files[slot]==NULL)
+            cli->files[slot]=argv[optind++];
+    }
+    for(cli->num_files=num_slots;cli->num_files>0 && cli->files[cli->num_files-1]==NULL;cli->num_files--);
+    return EXIT_OK;
+}
+
+// Function to print the command line help
+void print_usage(FILE *stream, const char *prog)
+{
+    fprintf(stream,
+            "Usage:\n"
+            "  %s -e [-i] cover.bmp [-m] secret.txt [[-o] stego.bmp|stego.delta] [-r [N]] [-k pass] [-D|-P|-L] [-S]\n"
+            "  %s -d [-i] stego.bmp|stego.delta [[-o] output] [-c cover.bmp] [-k pass]\n"
+            "  %s -u [-i] stego.bmp [-m] secret [offset]\n"
+            "  %s -s socket [workers]\n"
+            "  %s -a -c cover.bmp [-i] stego.delta [[-o] stego.bmp]\n"
+            "  %s -f [-i] cover.bmp secret... [-o dir] [-j jobs] [-r [N]] [-k pass] [-S]\n"
+            "Options:\n"
+            "  -e, --encode          hide a secret file in a BMP cover\n"
+            "  -d, --decode          extract the secret file of a stego image\n"
+            "  -u, --update          replace or patch the secret of a stego image in place\n"
+            "  -s, --serve           serve encode/decode/probe requests on a Unix socket\n"
+            "  -f, --fanout          encode every secret into its own copy of one cover\n"
+            "  -a, --apply           rebuild a stego image from its cover and delta\n"
+            "  -i, --input FILE      cover image (-e) or stego image (-d, -u)\n"
+            "  -m, --message FILE    secret file\n"
+            "  -o, --output FILE     stego image (-e), decoded file name (-d) or output directory (-f)\n"
+            "  -c, --cover FILE      cover image of a delta (-a, and checked by -d)\n"
+            "  -k, --key PASS        encrypt or decrypt the secret with a passphrase\n"
+            "  -r, --ecc[=N]         protect the secret with N Reed-Solomon parity bytes (default %d)\n"
+            "  -D, --direct          write the stego image with O_DIRECT\n"
+            "  -P, --delta           write only the bytes that differ from the cover (-e)\n"
+            "  -L, --lsb-plane       like -P but keep only the LSBs of those bytes\n"
+            "  -j, --jobs N          number of encoding threads for -f (default one per CPU)\n"
+            "  -S, --stats           print MSE and PSNR of the stego image\n"
+            "  -q, --quiet           print errors only\n"
+            "  -h, --help            print this help\n"
+            "Exit status is %d on success, %d when the operation fails and %d on a bad command line.\n",
+            prog,prog,prog,prog,prog,prog,DEFAULT_RS_PARITY,EXIT_OK,EXIT_FAILED,EXIT_USAGE);
+}
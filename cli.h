@@ -0,0 +1,55 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <stdio.h>
+#include "types.h"
+
+/* Exit codes of the tool */
+#define EXIT_OK 0
+#define EXIT_FAILED 1 // The operation itself failed
+#define EXIT_USAGE 2  // Invalid command line
+
+/* Input, secret and output slots, the list is NULL terminated */
+#define CLI_MAX_FILES 3
+
+/*
+ * Structure to store the parsed command line,
+ * file names are ordered the same way as the
+ * positional arguments of each mode
+ */
+
+typedef struct _CliInfo
+{
+    OperationType mode;
+
+    /* File names given with -i, -m, -o and -c */
+    char *input_fname;
+    char *secret_fname;
+    char *output_fname;
+    char *cover_fname;
+
+    /* Positional arguments merged with the named files */
+    char *files[CLI_MAX_FILES + 1];
+    int num_files;
+
+    /* Fan-out secrets, every positional argument after the cover */
+    char **secret_fnames;
+    int num_secrets;
+
+    /* Options shared by the modes */
+    char *passphrase;
+    int ecc_parity;
+    int direct_io;
+    int show_stats;
+    int num_workers;
+    int delta_output;
+    int delta_lsb_plane;
+} CliInfo;
+
+/* Parse argv with getopt, EXIT_OK or EXIT_USAGE */
+int read_cli_args(int argc, char *argv[], CliInfo *cli);
+
+/* Print the command line help */
+void print_usage(FILE *stream, const char *prog);
+
+#endif
@@ -4,4 +4,32 @@
 /* Magic string to identify whether stegged or not */
 #define MAGIC_STRING "#*"
 
+/* Size of the BMP header, stego data starts right after it */
+#define BMP_HEADER_SIZE 54
+
+/* Secret file extension is always stored as 4 characters */
+#define STEGO_EXTN_SIZE 4
+
+/* Image bytes used by magic string size, magic string, extn size, extn and file size */
+#define STEGO_HEADER_SIZE (32 + 8 * (sizeof(MAGIC_STRING) - 1) + 32 + 8 * STEGO_EXTN_SIZE + 32)
+
+/* ECC images repeat the extn size field, extn and file size with a check word right after the stego header */
+#define STEGO_HEADER_COPIES 2
+#define STEGO_HEADER_COPY_SIZE 16 // Bytes of one copy
+#define STEGO_HEADER_COPIES_SPAN (8 * STEGO_HEADER_COPIES * STEGO_HEADER_COPY_SIZE) // Image bytes holding the copies
+
+/* Flags kept in the upper bits of the extn size field, older images have none set */
+#define STEGO_EXTN_SIZE_MASK 0x0000ffff
+#define STEGO_FLAG_ECC 0x00010000
+#define STEGO_FLAG_CIPHER 0x00020000
+#define STEGO_PARITY_SHIFT 24 // Reed-Solomon parity bytes per codeword
+
+/* Extension of delta files holding only the bytes a stego image changes */
+#define DELTA_FILE_EXTN ".delta"
+
+/* Progress messages are suppressed with -q, errors are always printed */
+extern int quiet_mode;
+#define print_status(...) do { if(!quiet_mode) printf(__VA_ARGS__); } while(0)
+#define print_error(...) fprintf(stderr, __VA_ARGS__)
+
 #endif
@@ -0,0 +1,606 @@
+/* DOCUMENTATION
+Discription : Long running daemon mode.
+Listens on a Unix domain socket (SOCK_SEQPACKET, one request per message) and
+serves encode, decode and probe requests without starting a new process.
+Files are given either as paths or as "-" with the descriptor passed along
+with the message (SCM_RIGHTS), in the order of the "-" arguments.
+A passed descriptor may be a pipe or a socket : an input is read to its end
+into a memory file first, an output is written in order without truncating.
+Requests :
+ENCODE <cover.bmp> <secret> <stego.bmp> [extn] [ecc=<parity>] [key=<passphrase>]
+DECODE <stego.bmp> <output> [key=<passphrase>]
+PROBE <image.bmp>
+Replies are a single message "OK key=value ..." or "ERR <reason>".
+The main thread waits on the socket, the connections and the signals with epoll
+and queues each received request, any idle worker takes it. A connection is
+re-armed once its reply is sent, so its requests are still served in order but
+an idle client does not hold a worker.
+Worker threads and page-aligned image buffers are kept between requests.*/
+#define _GNU_SOURCE // accept4, MSG_CMSG_CLOEXEC
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include "daemon.h"
+#include "fileio.h"
+#include "encode.h"
+#include "decode.h"
+#include "types.h"
+#include "common.h"
+
+// Function to read and validate daemon arguments
+Status read_and_validate_daemon_args(char *files[], DaemonInfo *daemonInfo)
+{
+    if(files[0]==NULL) // Socket path is mandatory
+    {
+        print_error("\n.................SOCKET FILE NAME NOT GIVEN..............❓\n");
+        return e_failure;
+    }
+    if(strlen(files[0])>=sizeof(((struct sockaddr_un *)0)->sun_path))
+    {
+        print_error("\n.................SOCKET FILE NAME TOO LONG..............❌\n");
+        return e_failure;
+    }
+    daemonInfo->socket_fname=files[0];
+
+    daemonInfo->num_workers=DEFAULT_DAEMON_WORKERS;
+    if(files[1]!=NULL) // Optional number of worker threads
+    {
+        daemonInfo->num_workers=atoi(files[1]);
+        if(daemonInfo->num_workers<=0)
+        {
+            print_error("\n.................Invalid number of workers..............❌\n");
+            return e_failure;
+        }
+    }
+    return e_success;
+}
+
+// Function to encode a secret into a cover, everything is done in one pooled buffer
+Status daemon_encode(DaemonInfo *daemonInfo, int cover_fd, int secret_fd, int stego_fd, EncodeInfo *encInfo, char *reply, int reply_size)
+{
+    long cover_size=get_fd_size(cover_fd);
+    long secret_size=get_fd_size(secret_fd);
+    if(cover_size<BMP_HEADER_SIZE || secret_size<=0)
+    {
+        snprintf(reply,reply_size,"ERR invalid cover or empty secret");
+        return e_failure;
+    }
+
+    if(init_payload_ecc(encInfo)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR invalid ecc parity");
+        return e_failure;
+    }
+    if(init_payload_cipher(encInfo)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR cannot set up encryption");
+        if(encInfo->ecc_parity>0)
+            rs_free(&encInfo->rs);
+        return e_failure;
+    }
+    PoolBuffer *buf=pool_acquire(&daemonInfo->pool,cover_size+secret_size);
+    if(buf==NULL)
+    {
+        snprintf(reply,reply_size,"ERR out of memory");
+        if(encInfo->ecc_parity>0)
+            rs_free(&encInfo->rs);
+        return e_failure;
+    }
+    char *image=buf->data;
+    char *secret=buf->data+cover_size; // Secret is kept right after the cover
+    Status ret=e_failure;
+
+    if(read_full_at(cover_fd,image,cover_size,0)!=e_success || read_full_at(secret_fd,secret,secret_size,0)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR read failed");
+        goto out;
+    }
+
+    // Check if the cover has enough capacity to encode the secret
+    encInfo->image_capacity=get_image_size_for_bmp_buffer(image);
+    encInfo->size_secret_file=secret_size;
+    long span=get_stego_payload_span(get_payload_size(encInfo));
+    if(encInfo->image_capacity<span || cover_size<BMP_HEADER_SIZE+span)
+    {
+        snprintf(reply,reply_size,"ERR capacity %u too small for secret of %ld bytes",encInfo->image_capacity,secret_size);
+        goto out;
+    }
+    uint width,height;
+    get_bmp_dimensions_buffer(image,&width,&height);
+    init_embed_stats(&encInfo->stats,width,height); // Count flipped LSBs while embedding
+
+    if(encode_secret_to_buffer(image,secret,encInfo)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR out of memory");
+        goto out;
+    }
+    if(write_whole_fd(stego_fd,image,cover_size)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR write failed");
+        goto out;
+    }
+    unsigned long flipped=encInfo->stats.flipped[0]+encInfo->stats.flipped[1]+encInfo->stats.flipped[2];
+    snprintf(reply,reply_size,"OK op=encode size=%ld extn=%.4s bytes=%ld ecc=%d cipher=%d flipped=%lu psnr=%.2f",secret_size,encInfo->extn_secret_file,cover_size,
+             encInfo->ecc_parity,encInfo->passphrase!=NULL,flipped,get_psnr(flipped,3.0*width*height));
+    ret=e_success;
+out:
+    pool_release(&daemonInfo->pool,buf);
+    if(encInfo->ecc_parity>0)
+        rs_free(&encInfo->rs);
+    cipher_wipe(&encInfo->cipher);
+    return ret;
+}
+
+// Function to decode a secret, only the bytes carrying the payload are read
+Status daemon_decode(DaemonInfo *daemonInfo, int stego_fd, const char *out_fname, int out_fd, char *passphrase, char *reply, int reply_size)
+{
+    DecodeInfo decoInfo;
+    decoInfo.passphrase=passphrase;
+    char header[STEGO_HEADER_BUFFER_SIZE]={0};
+    long image_size=get_fd_size(stego_fd);
+
+    if(image_size<BMP_HEADER_SIZE+(long)STEGO_HEADER_SIZE || read_full_at(stego_fd,header,(image_size<(long)sizeof(header)) ? image_size : (long)sizeof(header),0)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR not a stego image");
+        return e_failure;
+    }
+    if(decode_header_from_buffer(header,&decoInfo)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR invalid magic string");
+        return e_failure;
+    }
+    long span=BMP_HEADER_SIZE+get_stego_payload_span(get_decode_payload_size(&decoInfo));
+    if(span>image_size)
+    {
+        snprintf(reply,reply_size,"ERR secret size %d exceeds image",decoInfo.size_file);
+        return e_failure;
+    }
+
+    PoolBuffer *buf=pool_acquire(&daemonInfo->pool,span+decoInfo.size_file);
+    if(buf==NULL)
+    {
+        snprintf(reply,reply_size,"ERR out of memory");
+        return e_failure;
+    }
+    char *image=buf->data;
+    char *secret=buf->data+span;
+    Status ret=e_failure;
+
+    if(read_full_at(stego_fd,image,span,0)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR read failed");
+        goto out;
+    }
+    if(decode_data_from_buffer(image,secret,&decoInfo)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR %s",decoInfo.error);
+        goto out;
+    }
+
+    if(out_fd<0) // Output name gets the decoded extension, like do_decoding
+    {
+        strncpy(decoInfo.out_fname,out_fname,sizeof(decoInfo.out_fname)-STEGO_EXTN_SIZE-1);
+        decoInfo.out_fname[sizeof(decoInfo.out_fname)-STEGO_EXTN_SIZE-1]='\0';
+        set_fname_extn(decoInfo.out_fname,sizeof(decoInfo.out_fname),decoInfo.ext_secret_file); // Append decoded extension
+        out_fd=open(decoInfo.out_fname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+        if(out_fd<0)
+        {
+            snprintf(reply,reply_size,"ERR cannot open %s",decoInfo.out_fname);
+            goto out;
+        }
+    }
+    else
+        strcpy(decoInfo.out_fname,"-");
+
+    if(write_whole_fd(out_fd,secret,decoInfo.size_file)==e_success)
+    {
+        snprintf(reply,reply_size,"OK op=decode size=%d extn=%s ecc=%d corrected=%ld cipher=%d out=%s",decoInfo.size_file,decoInfo.ext_secret_file,
+                 decoInfo.ecc_parity,decoInfo.corrected,(decoInfo.flags&STEGO_FLAG_CIPHER)!=0,decoInfo.out_fname);
+        ret=e_success;
+    }
+    else
+        snprintf(reply,reply_size,"ERR write failed");
+    if(out_fname!=NULL)
+        close(out_fd);
+out:
+    pool_release(&daemonInfo->pool,buf);
+    return ret;
+}
+
+// Function to report whether an image carries a secret and how much it can hold
+Status daemon_probe(int image_fd, char *reply, int reply_size)
+{
+    DecodeInfo decoInfo;
+    char header[STEGO_HEADER_BUFFER_SIZE]={0};
+    long image_size=get_fd_size(image_fd);
+
+    if(image_size<BMP_HEADER_SIZE+(long)STEGO_HEADER_SIZE || read_full_at(image_fd,header,(image_size<(long)sizeof(header)) ? image_size : (long)sizeof(header),0)!=e_success)
+    {
+        snprintf(reply,reply_size,"ERR not a bmp image");
+        return e_failure;
+    }
+    uint capacity=get_image_size_for_bmp_buffer(header);
+    long max_secret=((long)capacity-(long)STEGO_HEADER_SIZE)/8;
+    if(max_secret<0) // Too small to even hold the stego header
+        max_secret=0;
+    if(decode_header_from_buffer(header,&decoInfo)==e_success)
+        snprintf(reply,reply_size,"OK op=probe stego=1 extn=%s size=%d ecc=%d cipher=%d capacity=%ld",decoInfo.ext_secret_file,decoInfo.size_file,
+                 decoInfo.ecc_parity,(decoInfo.flags&STEGO_FLAG_CIPHER)!=0,max_secret);
+    else
+        snprintf(reply,reply_size,"OK op=probe stego=0 capacity=%ld",max_secret);
+    return e_success;
+}
+
+// Function to get the descriptor for a path argument, "-" takes the next passed descriptor, an input pipe is spooled first
+static int get_request_fd(const char *arg, int flags, int *fds, int num_fds, int *next_fd, int *opened, int *num_opened)
+{
+    int fd;
+    if(strcmp(arg,"-")==0)
+    {
+        fd=(*next_fd<num_fds) ? fds[(*next_fd)++] : -1;
+        if(fd<0 || flags!=O_RDONLY || lseek(fd,0,SEEK_CUR)>=0)
+            return fd;
+        fd=spool_fd(fd);
+    }
+    else
+        fd=open(arg,flags,0644);
+    if(fd>=0)
+        opened[(*num_opened)++]=fd;
+    return fd;
+}
+
+// Function to parse one request message and run it
+Status handle_request(DaemonInfo *daemonInfo, char *request, int *fds, int num_fds, char *reply, int reply_size)
+{
+    char *args[8],*save;
+    int argc=0,next_fd=0,opened[MAX_REQUEST_FDS],num_opened=0;
+    Status ret=e_failure;
+
+    for(char *tok=strtok_r(request," \t\r\n",&save);tok!=NULL && argc<8;tok=strtok_r(NULL," \t\r\n",&save))
+        args[argc++]=tok;
+    if(argc==0)
+    {
+        snprintf(reply,reply_size,"ERR empty request");
+        return e_failure;
+    }
+
+    if(strcmp(args[0],"ENCODE")==0 && argc>=4)
+    {
+        EncodeInfo encInfo={0};
+        const char *extn=get_fname_extn(args[2]); // Passed descriptors carry no name
+        for(int i=4;i<argc;i++) // Optional extn, ecc=<parity> and key=<passphrase>
+        {
+            if(strncmp(args[i],"ecc=",4)==0)
+                encInfo.ecc_parity=atoi(args[i]+4);
+            else if(strncmp(args[i],"key=",4)==0)
+                encInfo.passphrase=args[i]+4;
+            else
+                extn=args[i];
+        }
+        if(set_secret_file_extn(extn,&encInfo)!=e_success)
+        {
+            snprintf(reply,reply_size,"ERR extension too long");
+            return e_failure;
+        }
+        int cover_fd=get_request_fd(args[1],O_RDONLY,fds,num_fds,&next_fd,opened,&num_opened);
+        int secret_fd=get_request_fd(args[2],O_RDONLY,fds,num_fds,&next_fd,opened,&num_opened);
+        int stego_fd=-1;
+        if(cover_fd>=0 && secret_fd>=0) // Do not create the output for a request that cannot run
+            stego_fd=get_request_fd(args[3],O_WRONLY|O_CREAT,fds,num_fds,&next_fd,opened,&num_opened);
+        if(cover_fd<0 || secret_fd<0 || stego_fd<0)
+            snprintf(reply,reply_size,"ERR cannot open files");
+        else
+            ret=daemon_encode(daemonInfo,cover_fd,secret_fd,stego_fd,&encInfo,reply,reply_size);
+    }
+    else if(strcmp(args[0],"DECODE")==0 && argc>=2)
+    {
+        char *passphrase=NULL;
+        if(strncmp(args[argc-1],"key=",4)==0) // Optional key=<passphrase> comes last
+            passphrase=args[--argc]+4;
+        int stego_fd=get_request_fd(args[1],O_RDONLY,fds,num_fds,&next_fd,opened,&num_opened);
+        const char *out=(argc>=3) ? args[2] : "out"; // Default output file name
+        int out_fd=-1;
+        if(strcmp(out,"-")==0)
+        {
+            out_fd=get_request_fd(out,O_WRONLY,fds,num_fds,&next_fd,opened,&num_opened);
+            out=NULL;
+        }
+        if(stego_fd<0 || (out==NULL && out_fd<0))
+            snprintf(reply,reply_size,"ERR cannot open files");
+        else
+            ret=daemon_decode(daemonInfo,stego_fd,out,out_fd,passphrase,reply,reply_size);
+    }
+    else if(strcmp(args[0],"PROBE")==0 && argc==2)
+    {
+        int image_fd=get_request_fd(args[1],O_RDONLY,fds,num_fds,&next_fd,opened,&num_opened);
+        if(image_fd<0)
+            snprintf(reply,reply_size,"ERR cannot open file");
+        else
+            ret=daemon_probe(image_fd,reply,reply_size);
+    }
+    else
+        snprintf(reply,reply_size,"ERR unsupported request");
+
+    for(int i=0;i<num_opened;i++)
+        close(opened[i]);
+    return ret;
+}
+
+// Function to receive one request message along with any passed descriptors, without blocking
+static ssize_t receive_request(int conn_fd, char *request, int *fds, int *num_fds)
+{
+    char control[CMSG_SPACE(sizeof(int)*MAX_REQUEST_FDS)];
+    struct iovec iov={request,MAX_REQUEST_SIZE-1};
+    struct msghdr msg={0};
+    msg.msg_iov=&iov;
+    msg.msg_iovlen=1;
+    msg.msg_control=control;
+    msg.msg_controllen=sizeof(control);
+
+    ssize_t n=recvmsg(conn_fd,&msg,MSG_CMSG_CLOEXEC|MSG_DONTWAIT);
+    *num_fds=0;
+    if(n<0)
+        return n;
+    request[n]='\0';
+    for(struct cmsghdr *cmsg=CMSG_FIRSTHDR(&msg);cmsg!=NULL;cmsg=CMSG_NXTHDR(&msg,cmsg))
+    {
+        if(cmsg->cmsg_level==SOL_SOCKET && cmsg->cmsg_type==SCM_RIGHTS)
+        {
+            int count=(cmsg->cmsg_len-CMSG_LEN(0))/sizeof(int);
+            memcpy(fds+*num_fds,CMSG_DATA(cmsg),sizeof(int)*count);
+            *num_fds+=count;
+        }
+    }
+    return n;
+}
+
+// Function to add or re-arm a descriptor in epoll, a EPOLLONESHOT connection reports one request until it is re-armed
+static int watch_fd(DaemonInfo *daemonInfo, int op, int fd, uint32_t events)
+{
+    struct epoll_event ev={0};
+    ev.events=events;
+    ev.data.fd=fd;
+    return epoll_ctl(daemonInfo->epoll_fd,op,fd,&ev);
+}
+
+// Function to append a received request to the queue and wake one worker
+static void queue_job(DaemonInfo *daemonInfo, DaemonJob *job)
+{
+    job->next=NULL;
+    pthread_mutex_lock(&daemonInfo->lock);
+    if(daemonInfo->queue_tail!=NULL)
+        daemonInfo->queue_tail->next=job;
+    else
+        daemonInfo->queue_head=job;
+    daemonInfo->queue_tail=job;
+    pthread_cond_signal(&daemonInfo->ready);
+    pthread_mutex_unlock(&daemonInfo->lock);
+}
+
+// Function to take the oldest request, NULL once the daemon is stopping
+static DaemonJob *take_job(DaemonInfo *daemonInfo)
+{
+    pthread_mutex_lock(&daemonInfo->lock);
+    while(daemonInfo->queue_head==NULL && !daemonInfo->stopping)
+        pthread_cond_wait(&daemonInfo->ready,&daemonInfo->lock);
+    DaemonJob *job=NULL;
+    if(!daemonInfo->stopping)
+    {
+        job=daemonInfo->queue_head;
+        daemonInfo->queue_head=job->next;
+        if(daemonInfo->queue_head==NULL)
+            daemonInfo->queue_tail=NULL;
+    }
+    pthread_mutex_unlock(&daemonInfo->lock);
+    return job;
+}
+
+// Function to close the descriptors passed with a request and free it
+static void free_job(DaemonJob *job)
+{
+    for(int i=0;i<job->num_fds;i++) // Passed descriptors belong to us now
+        close(job->fds[i]);
+    free(job);
+}
+
+// Worker thread: serve queued requests from any connection
+static void *daemon_worker(void *arg)
+{
+    DaemonInfo *daemonInfo=arg;
+    char reply[MAX_REQUEST_SIZE];
+    DaemonJob *job;
+
+    while((job=take_job(daemonInfo))!=NULL)
+    {
+        handle_request(daemonInfo,job->request,job->fds,job->num_fds,reply,sizeof(reply));
+        send(job->conn_fd,reply,strlen(reply),MSG_NOSIGNAL);
+        watch_fd(daemonInfo,EPOLL_CTL_MOD,job->conn_fd,EPOLLIN|EPOLLONESHOT); // Ready for its next request
+        free_job(job);
+    }
+    return NULL;
+}
+
+// Function to accept the pending connections and watch them for requests
+static void accept_connections(DaemonInfo *daemonInfo)
+{
+    int conn_fd;
+    while((conn_fd=accept4(daemonInfo->listen_fd,NULL,NULL,SOCK_CLOEXEC))>=0)
+    {
+        int *conns=realloc(daemonInfo->conns,(daemonInfo->num_conns+1)*sizeof(int));
+        if(conns==NULL || watch_fd(daemonInfo,EPOLL_CTL_ADD,conn_fd,EPOLLIN|EPOLLONESHOT)!=0)
+        {
+            if(conns!=NULL)
+                daemonInfo->conns=conns;
+            close(conn_fd);
+            continue;
+        }
+        daemonInfo->conns=conns;
+        daemonInfo->conns[daemonInfo->num_conns++]=conn_fd;
+    }
+}
+
+// Function to close a connection the client has left
+static void close_connection(DaemonInfo *daemonInfo, int conn_fd)
+{
+    for(int i=0;i<daemonInfo->num_conns;i++)
+    {
+        if(daemonInfo->conns[i]==conn_fd)
+        {
+            daemonInfo->conns[i]=daemonInfo->conns[--daemonInfo->num_conns];
+            break;
+        }
+    }
+    close(conn_fd); // Also removes it from epoll
+}
+
+// Function to read the request of a ready connection and queue it
+static void read_connection(DaemonInfo *daemonInfo, int conn_fd)
+{
+    DaemonJob *job=malloc(sizeof(DaemonJob));
+    if(job==NULL)
+    {
+        close_connection(daemonInfo,conn_fd);
+        return;
+    }
+    job->conn_fd=conn_fd;
+    ssize_t n=receive_request(conn_fd,job->request,job->fds,&job->num_fds);
+    if(n>0)
+    {
+        queue_job(daemonInfo,job);
+        return;
+    }
+    free_job(job);
+    if(n<0 && (errno==EAGAIN || errno==EINTR)) // Nothing to read after all
+        watch_fd(daemonInfo,EPOLL_CTL_MOD,conn_fd,EPOLLIN|EPOLLONESHOT);
+    else
+        close_connection(daemonInfo,conn_fd);
+}
+
+// Function to dispatch socket, connection and signal events until SIGINT/SIGTERM
+static void dispatch_events(DaemonInfo *daemonInfo, int signal_fd)
+{
+    struct epoll_event events[64];
+    for(;;)
+    {
+        int n=epoll_wait(daemonInfo->epoll_fd,events,64,-1);
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<0)
+            return;
+        for(int i=0;i<n;i++)
+        {
+            int fd=events[i].data.fd;
+            if(fd==signal_fd)
+                return;
+            if(fd==daemonInfo->listen_fd)
+                accept_connections(daemonInfo);
+            else
+                read_connection(daemonInfo,fd);
+        }
+    }
+}
+
+// Function to listen on the socket and serve requests until SIGINT/SIGTERM
+Status run_daemon(DaemonInfo *daemonInfo)
+{
+    struct sockaddr_un addr={0};
+    sigset_t sigs;
+
+    if(pool_init(&daemonInfo->pool,daemonInfo->num_workers,DEFAULT_DAEMON_BUF_SIZE)!=e_success)
+    {
+        print_error("ERROR: Unable to allocate buffer pool ❌\n");
+        return e_failure;
+    }
+
+    daemonInfo->listen_fd=socket(AF_UNIX,SOCK_SEQPACKET|SOCK_CLOEXEC|SOCK_NONBLOCK,0);
+    if(daemonInfo->listen_fd<0)
+    {
+        perror("socket");
+        pool_destroy(&daemonInfo->pool);
+        return e_failure;
+    }
+    addr.sun_family=AF_UNIX;
+    strcpy(addr.sun_path,daemonInfo->socket_fname);
+    unlink(daemonInfo->socket_fname); // Remove a stale socket left by an earlier run
+    if(bind(daemonInfo->listen_fd,(struct sockaddr *)&addr,sizeof(addr))!=0 || listen(daemonInfo->listen_fd,SOMAXCONN)!=0)
+    {
+        perror("bind");
+        print_error("ERROR: Unable to listen on ❌ %s\n",daemonInfo->socket_fname);
+        close(daemonInfo->listen_fd);
+        pool_destroy(&daemonInfo->pool);
+        return e_failure;
+    }
+
+    // Workers must not take the signals, the main thread reads them from a signalfd
+    sigemptyset(&sigs);
+    sigaddset(&sigs,SIGINT);
+    sigaddset(&sigs,SIGTERM);
+    pthread_sigmask(SIG_BLOCK,&sigs,NULL);
+    int signal_fd=signalfd(-1,&sigs,SFD_CLOEXEC);
+    daemonInfo->epoll_fd=epoll_create1(EPOLL_CLOEXEC);
+    if(signal_fd<0 || daemonInfo->epoll_fd<0 || watch_fd(daemonInfo,EPOLL_CTL_ADD,signal_fd,EPOLLIN)!=0 ||
+       watch_fd(daemonInfo,EPOLL_CTL_ADD,daemonInfo->listen_fd,EPOLLIN)!=0)
+    {
+        perror("epoll");
+        daemonInfo->num_workers=0; // Nothing is started
+    }
+
+    pthread_mutex_init(&daemonInfo->lock,NULL);
+    pthread_cond_init(&daemonInfo->ready,NULL);
+    daemonInfo->queue_head=daemonInfo->queue_tail=NULL;
+    daemonInfo->stopping=0;
+    daemonInfo->conns=NULL;
+    daemonInfo->num_conns=0;
+    daemonInfo->workers=calloc(daemonInfo->num_workers>0 ? daemonInfo->num_workers : 1,sizeof(pthread_t));
+    int started=0;
+    while(daemonInfo->workers!=NULL && started<daemonInfo->num_workers)
+    {
+        if(pthread_create(&daemonInfo->workers[started],NULL,daemon_worker,daemonInfo)!=0)
+            break;
+        started++;
+    }
+    if(started>0)
+    {
+        print_status("\n>>>>>>>>>>>>>> DAEMON LISTENING ON %s WITH %d WORKERS <<<<<<<<<<<<<<✅\n",daemonInfo->socket_fname,started);
+        fflush(stdout);
+        dispatch_events(daemonInfo,signal_fd);
+    }
+
+    // Running requests finish, queued ones are dropped with their connections
+    pthread_mutex_lock(&daemonInfo->lock);
+    daemonInfo->stopping=1;
+    pthread_cond_broadcast(&daemonInfo->ready);
+    pthread_mutex_unlock(&daemonInfo->lock);
+    for(int i=0;i<started;i++)
+        pthread_join(daemonInfo->workers[i],NULL);
+    while(daemonInfo->queue_head!=NULL)
+    {
+        DaemonJob *job=daemonInfo->queue_head;
+        daemonInfo->queue_head=job->next;
+        free_job(job);
+    }
+    for(int i=0;i<daemonInfo->num_conns;i++)
+        close(daemonInfo->conns[i]);
+    free(daemonInfo->conns);
+    pthread_cond_destroy(&daemonInfo->ready);
+    pthread_mutex_destroy(&daemonInfo->lock);
+
+    if(daemonInfo->epoll_fd>=0)
+        close(daemonInfo->epoll_fd);
+    if(signal_fd>=0)
+        close(signal_fd);
+    close(daemonInfo->listen_fd);
+    unlink(daemonInfo->socket_fname);
+    free(daemonInfo->workers);
+    pool_destroy(&daemonInfo->pool);
+    return started>0 ? e_success : e_failure;
+}
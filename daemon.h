@@ -0,0 +1,72 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "types.h"
+#include "bufpool.h"
+#include "encode.h"
+
+/*
+ * Structure to store information required for
+ * serving encode/decode/probe requests over a
+ * Unix domain socket
+ */
+
+#define DEFAULT_DAEMON_WORKERS 4
+#define DEFAULT_DAEMON_BUF_SIZE (4 * 1024 * 1024)
+#define MAX_REQUEST_SIZE 4096
+#define MAX_REQUEST_FDS 3
+
+/* One received request waiting for a worker */
+typedef struct _DaemonJob
+{
+    int conn_fd;
+    int fds[MAX_REQUEST_FDS];
+    int num_fds;
+    char request[MAX_REQUEST_SIZE];
+    struct _DaemonJob *next;
+} DaemonJob;
+
+typedef struct _DaemonInfo
+{
+    char *socket_fname;
+    int listen_fd;
+    int epoll_fd;
+    int num_workers;
+    pthread_t *workers;
+
+    /* Connections open on the socket, owned by the main thread */
+    int *conns;
+    int num_conns;
+
+    /* Requests are queued by the main thread and taken by any idle worker */
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    DaemonJob *queue_head;
+    DaemonJob *queue_tail;
+    int stopping;
+
+    /* Buffers kept warm between requests */
+    BufferPool pool;
+} DaemonInfo;
+
+/* Daemon function prototype */
+
+/* Read and validate the socket path and optional number of workers */
+Status read_and_validate_daemon_args(char *files[], DaemonInfo *daemonInfo);
+
+/* Listen on the socket and serve requests until SIGINT/SIGTERM */
+Status run_daemon(DaemonInfo *daemonInfo);
+
+/* Handle one request message and fill the reply */
+Status handle_request(DaemonInfo *daemonInfo, char *request, int *fds, int num_fds, char *reply, int reply_size);
+
+/* Encode request: ENCODE <cover.bmp> <secret> <stego.bmp> [extn] [ecc=<parity>] [key=<passphrase>] */
+Status daemon_encode(DaemonInfo *daemonInfo, int cover_fd, int secret_fd, int stego_fd, EncodeInfo *encInfo, char *reply, int reply_size);
+
+/* Decode request: DECODE <stego.bmp> <output> [key=<passphrase>] */
+Status daemon_decode(DaemonInfo *daemonInfo, int stego_fd, const char *out_fname, int out_fd, char *passphrase, char *reply, int reply_size);
+
+/* Probe request: PROBE <image.bmp> */
+Status daemon_probe(int image_fd, char *reply, int reply_size);
+
+#endif
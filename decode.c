@@ -13,40 +13,47 @@ Saves the decoded data into an output file.*/
 #include "decode.h"
 #include "types.h"
 #include "common.h"
-#include <unistd.h>
+#include "ecc.h"
+#include "encode.h"
+#include <sys/stat.h>
+#include "fileio.h"
 
-// Function to read and validate decoding arguments
-Status read_and_validate_decode_args(char *argv[], DecodeInfo *decoinfo)
+static void extract_bytes_from_file(DecodeInfo *decoinfo, char *data, long size, void *cursor);
+static void extract_bytes_from_buffer(DecodeInfo *decoinfo, char *data, long size, void *cursor);
+
+// Function to read and validate decoding file names (stego, optional output)
+Status read_and_validate_decode_args(char *files[], DecodeInfo *decoinfo)
 {
-    // Check if the stego image file has a .bmp extension
-    if(strstr(argv[2],".bmp") != NULL)
+    // Check if the stego image file has a .bmp extension, or is a delta against a cover
+    if(files[0]!=NULL)
     {
-        if(strcmp(strstr(argv[2],".bmp"),".bmp")==0) // Validate .bmp extension
+        if(has_fname_extn(files[0],".bmp") || has_fname_extn(files[0],DELTA_FILE_EXTN)) // Validate extension
         {
-            decoinfo->stego_image_fname=argv[2]; // Set stego image file name
+            decoinfo->stego_image_fname=files[0]; // Set stego image file name
         }
         else
         {
-            printf("\n********** Invalid Extension ***********❌\n");
+            print_error("\n********** Invalid Extension ***********❌\n");
             return e_failure;
         }
     }
     else
     {
-        printf("\n<<<<<<<<<<<<<<<< PROBLEM WITH THE ENCODDED FILE NAME DECODING STOPPED >>>>>>>>>❌\n");
+        print_error("\n<<<<<<<<<<<<<<<< PROBLEM WITH THE ENCODDED FILE NAME DECODING STOPPED >>>>>>>>>❌\n");
         return e_failure;
     }
 
     // Set output file name (default is "out" if not provided)
-    if(argv[3]==NULL)
+    if(files[1]==NULL)
     {
        strcpy(decoinfo->out_fname,"out"); // Default output file name
     } 
     else
     {
-        strcpy(decoinfo->out_fname,argv[3]); // Use provided output file name
+        strncpy(decoinfo->out_fname,files[1],sizeof(decoinfo->out_fname)-STEGO_EXTN_SIZE-1); // Use provided output file name
+        decoinfo->out_fname[sizeof(decoinfo->out_fname)-STEGO_EXTN_SIZE-1]='\0';
     }
-    printf("\n<<<<<<<<<<<< READING AND VALIDATION OF FILES ARE SUCCESSFULL >>>>>>>>>>>✅\n");
+    print_status("\n<<<<<<<<<<<< READING AND VALIDATION OF FILES ARE SUCCESSFULL >>>>>>>>>>>✅\n");
     return e_success;
 }
 
@@ -55,74 +62,67 @@ Status do_decoding(DecodeInfo *decoinfo)
 {
     // Open the stego image file
     int open_file = open_file_src(decoinfo);
-    sleep(3); // Simulate delay
     if(open_file != e_success)
     {
-        printf("\n**************** ERROR IN OPENING FILE HEADER *******************❌\n");
+        print_error("\n**************** ERROR IN OPENING FILE HEADER *******************❌\n");
         return e_failure;
     }
-    printf("\n<<<<<<<<<<<<< FILE OPENING FOR DECODING IS SUCCESSFULL >>>>>>>>>>>>>>>>✅\n");
+    print_status("\n<<<<<<<<<<<<< FILE OPENING FOR DECODING IS SUCCESSFULL >>>>>>>>>>>>>>>>✅\n");
 
     // Skip the BMP header (first 54 bytes)
     int skip_hed=skip_bmp_header(decoinfo->fptr_stego_image);
-    sleep(3); // Simulate delay
     if(skip_hed != e_success)
     {
-        printf("\n**************** EROR IN SKIPING THE HEADER FOR DECODING SECRET *****************❌\n");
+        print_error("\n**************** EROR IN SKIPING THE HEADER FOR DECODING SECRET *****************❌\n");
         return e_failure;
     }
-    printf("\n<<<<<<<<<<<<<<< SKIPING BMP HEADER IS SUCCESSFULL >>>>>>>>>>>>>>>✅\n");
+    print_status("\n<<<<<<<<<<<<<<< SKIPING BMP HEADER IS SUCCESSFULL >>>>>>>>>>>>>>>✅\n");
 
     // Decode the magic string size
     decoinfo->size_magic_string=decode_lsb_to_size(decoinfo->fptr_stego_image); // Decode size of magic string
     int magic_str=decode_magic_string(decoinfo->size_magic_string,decoinfo); // Decode magic string
-    sleep(3); // Simulate delay
     if(magic_str!=e_success)
     {
-        printf("\n****************  ERROR : INVALID MAGIC STRING *************❌\n");
+        print_error("\n****************  ERROR : INVALID MAGIC STRING *************❌\n");
         return e_failure;
     }
-    printf("\n>>>>><<<<<<<<< DECODING MAGIC STRING IS SUCCESSFULL >>>>>>>>>>>>>>>✅\n");
+    print_status("\n>>>>><<<<<<<<< DECODING MAGIC STRING IS SUCCESSFULL >>>>>>>>>>>>>>>✅\n");
 
     // Decode the secret file extension size
     int exten_size =decode_secret_file_ext_size(decoinfo); // Decode size of secret file extension
-    sleep(3); // Simulate delay
     if(exten_size!=e_success)
     {
-        printf("\n ****************** Erorr : not able find size of extension ***************\n");
+        print_error("\n ****************** Erorr : not able find size of extension ***************\n");
         return e_failure;
     }
-    printf("\n<<<<<<<<<<<<< SECRETE FILE EXTENSION SIZE IS FOUNDED SUCCESSFULLY >>>>>>>>>>>>>>>>>>>✅\n");
+    print_status("\n<<<<<<<<<<<<< SECRETE FILE EXTENSION SIZE IS FOUNDED SUCCESSFULLY >>>>>>>>>>>>>>>>>>>✅\n");
 
     // Decode the secret file extension
     int extn=decode_secret_file_extn(decoinfo); // Decode secret file extension
-    sleep(3); // Simulate delay
     if(extn!=e_success)
     {
-        printf("\n********************* EROR IN EXTENSION *****************❌\n");
+        print_error("\n********************* EROR IN EXTENSION *****************❌\n");
         return e_failure;
     }
-    printf("\n<<<<<<<<<<<<< SECRETE FILE EXTENSION FOUNDED SUCCESSFULLY >>>>>>>>>>>>>>>>>>>✅\n");
+    print_status("\n<<<<<<<<<<<<< SECRETE FILE EXTENSION FOUNDED SUCCESSFULLY >>>>>>>>>>>>>>>>>>>✅\n");
 
     // Decode the size of the secret file
     int size=decode_secret_file_size(decoinfo); // Decode size of secret file
-    sleep(5); // Simulate delay
     if(size!=e_success)
     {
-        printf("\n ****************** Erorr : not able find size of secrete file ***************❌\n");
+        print_error("\n ****************** Erorr : not able find size of secrete file ***************❌\n");
         return e_failure;
     }
-    printf("\n<<<<<<<<<<<<< SECRETE FILE SIZE IS FOUNDED SUCCESSFULLY >>>>>>>>>>>>>>>>>>>✅\n");
+    print_status("\n<<<<<<<<<<<<< SECRETE FILE SIZE IS FOUNDED SUCCESSFULLY >>>>>>>>>>>>>>>>>>>✅\n");
 
     // Decode the data of the secret file
     int dta= decode_secret_file_data(decoinfo); // Decode secret file data
-    sleep(3); // Simulate delay
     if(dta!=e_success)
     {
-        printf("\n********** NOT ABLE DECODE THE SECRETE FILE DATA ***************❌\n");
+        print_error("\n********** NOT ABLE DECODE THE SECRETE FILE DATA ***************❌\n");
         return e_failure;
     }
-    printf("\n<<<<<<<<<<<<< SECRETE FILE DATA FOUNDED SUCCESSFULLY >>>>>>>>>>>>>>>>>>>✅\n");
+    print_status("\n<<<<<<<<<<<<< SECRETE FILE DATA FOUNDED SUCCESSFULLY >>>>>>>>>>>>>>>>>>>✅\n");
     return e_success;
 }
 
@@ -139,7 +139,7 @@ Status open_file_src(DecodeInfo *decoinfo)
     decoinfo->fptr_stego_image=fopen(decoinfo->stego_image_fname,"r"); // Open stego image file
     if ( decoinfo->fptr_stego_image== NULL) // Check for file open error
     {
-    	printf("\n____________ERROR : FILE IS NOT EXIST_____________❌\n");
+    	print_error("\n____________ERROR : FILE IS NOT EXIST_____________❌\n");
     	return e_failure;
     }
     return e_success;
@@ -167,22 +167,23 @@ int decode_lsb_to_size(FILE *fptr_stego)
 // Function to decode the magic string
 Status decode_magic_string(int size,DecodeInfo *decoinfo)
 {
-    char magic_str[size],user_str[size];
+    if(size!=strlen(MAGIC_STRING)) // Not a stego image, do not read a garbage length
+    {
+        print_error("\n************* Magic string is not matching ***********❌\n");
+        return e_failure;
+    }
+    char magic_str[size];
 
     for(int i=0;i<size;i++) // Decode each character of magic string
     {
         magic_str[i]=decode_lsb_to_byte(decoinfo->fptr_stego_image); // Decode byte from LSB
     }
-    printf("\n>>>>>>>>>>>ENTER THE MAGIC STRING : ");
-    scanf(" %s",user_str); // Get user input for magic string
-    if(strcmp(user_str,MAGIC_STRING)!=0) // Compare with expected magic string
+    if(memcmp(magic_str,MAGIC_STRING,size)!=0) // Compare with expected magic string
     {
-        printf("\n************* Entered wrong Magic string ***********❌\n");
+        print_error("\n************* Magic string is not matching ***********❌\n");
         return e_failure;
     }
-    printf("\n\n______________________Loading 🔃___________________\n");
-    sleep(5); // Simulate delay
-    printf("\n>>>>>>>>>>>>>>>>>>> MAGIC STRING IS MATCHING <<<<<<<<<<<<<<<<✅\n");
+    print_status("\n>>>>>>>>>>>>>>>>>>> MAGIC STRING IS MATCHING <<<<<<<<<<<<<<<<✅\n");
     return e_success;
 }
 
@@ -203,13 +204,162 @@ char decode_lsb_to_byte(FILE *fptr_stego)
     return data; // Return decoded byte
 }
 
-// Function to decode the size of the secret file extension
+// Function to decode the size of the secret file extension, the flags are split off once the header copies are checked
 Status decode_secret_file_ext_size(DecodeInfo *decoinfo)
 {
     decoinfo->size_ext=decode_lsb_to_size(decoinfo->fptr_stego_image); // Decode size from LSB
     return e_success;
 }
 
+// Function to read a big endian 32 bit value of a header copy
+static uint get_copy_field(const unsigned char *copy)
+{
+    return (uint)copy[0]<<24|(uint)copy[1]<<16|(uint)copy[2]<<8|copy[3];
+}
+
+// Function to check the extn size field, extn and file size against the copies an ECC image keeps after the stego header
+Status decode_stego_header_copies(DecodeInfo *decoinfo, const char *carriers)
+{
+    unsigned char copies[STEGO_HEADER_COPIES][STEGO_HEADER_COPY_SIZE],packed[STEGO_HEADER_COPY_SIZE];
+    for(int c=0;c<STEGO_HEADER_COPIES;c++)
+        for(int i=0;i<STEGO_HEADER_COPY_SIZE;i++,carriers+=8)
+            copies[c][i]=decode_byte_from_lsb(carriers);
+
+    const unsigned char *found=NULL;
+    for(int c=0;c<STEGO_HEADER_COPIES && found==NULL;c++) // The first intact copy of an ECC header wins
+    {
+        pack_stego_header_copy(get_copy_field(copies[c]),(const char *)copies[c]+4,get_copy_field(copies[c]+8),packed);
+        if(memcmp(packed,copies[c],STEGO_HEADER_COPY_SIZE)==0 && (get_copy_field(copies[c])&STEGO_FLAG_ECC))
+            found=copies[c];
+    }
+    if(found==NULL && (decoinfo->size_ext&STEGO_FLAG_ECC)) // Both copies damaged, each bit is the majority of the header and its copies
+    {
+        pack_stego_header_copy(decoinfo->size_ext,decoinfo->ext_secret_file,decoinfo->size_file,packed);
+        for(int i=0;i<STEGO_HEADER_COPY_SIZE;i++)
+            packed[i]=(packed[i]&copies[0][i])|(packed[i]&copies[1][i])|(copies[0][i]&copies[1][i]);
+        found=packed;
+    }
+    if(found!=NULL) // Otherwise there are no copies, the payload follows the header
+    {
+        decoinfo->size_ext=get_copy_field(found);
+        memcpy(decoinfo->ext_secret_file,found+4,STEGO_EXTN_SIZE);
+        decoinfo->size_file=get_copy_field(found+8);
+    }
+    return decode_stego_flags(decoinfo);
+}
+
+// Function to split the decoded extension size field into size and header flags
+Status decode_stego_flags(DecodeInfo *decoinfo)
+{
+    decoinfo->flags=decoinfo->size_ext&~STEGO_EXTN_SIZE_MASK;
+    decoinfo->size_ext&=STEGO_EXTN_SIZE_MASK;
+    decoinfo->ecc_parity=0;
+    decoinfo->corrected=0;
+    if(decoinfo->flags&~(STEGO_FLAG_ECC|STEGO_FLAG_CIPHER|(0xffu<<STEGO_PARITY_SHIFT))) // Written by a newer version
+        return e_failure;
+    if(decoinfo->flags&STEGO_FLAG_ECC)
+    {
+        decoinfo->ecc_parity=(uint)decoinfo->flags>>STEGO_PARITY_SHIFT;
+        if(decoinfo->ecc_parity<2 || decoinfo->ecc_parity>MAX_RS_PARITY)
+            return e_failure;
+    }
+    return e_success;
+}
+
+// Function to get the number of embedded bytes holding the secret data
+long get_decode_payload_size(DecodeInfo *decoinfo)
+{
+    long size=decoinfo->size_file;
+    if(decoinfo->flags&STEGO_FLAG_CIPHER) // Salt, nonce and key check
+        size+=CIPHER_HEADER_SIZE;
+    if(decoinfo->ecc_parity>0) // Header copies, then the codewords
+        size=STEGO_HEADER_COPIES*STEGO_HEADER_COPY_SIZE+rs_encoded_size(decoinfo->ecc_parity,size);
+    return size;
+}
+
+// Function to extract the embedded payload, correct errors and decrypt it into the secret data
+Status decode_payload(DecodeInfo *decoinfo, char *secret, ExtractFn extract, void *cursor)
+{
+    int encrypted=(decoinfo->flags&STEGO_FLAG_CIPHER)!=0;
+    long size=decoinfo->size_file;
+    char params[CIPHER_HEADER_SIZE];
+
+    if(encrypted && decoinfo->passphrase==NULL)
+    {
+        decoinfo->error="passphrase required";
+        return e_failure;
+    }
+
+    if(decoinfo->ecc_parity>0) // Correct salt, nonce, key check and data together, then decrypt
+    {
+        RSCodec rs;
+        long header=encrypted ? CIPHER_HEADER_SIZE : 0;
+        long payload_size=rs_encoded_size(decoinfo->ecc_parity,header+size);
+        char *payload=malloc(payload_size+header+size); // Codewords, then the corrected bytes
+        if(payload==NULL || rs_init(&rs,decoinfo->ecc_parity)!=e_success)
+        {
+            free(payload);
+            decoinfo->error="out of memory";
+            return e_failure;
+        }
+        char *data=payload+payload_size;
+        extract(decoinfo,payload,payload_size,cursor);
+        Status ret=rs_decode_payload(&rs,payload,header+size,data,&decoinfo->corrected);
+        rs_free(&rs);
+        memcpy(params,data,header);
+        memcpy(secret,data+header,size);
+        free(payload);
+        if(ret!=e_success)
+        {
+            decoinfo->error="too many errors to correct";
+            return e_failure;
+        }
+    }
+    else if(encrypted)
+        extract(decoinfo,params,CIPHER_HEADER_SIZE,cursor);
+
+    if(encrypted && cipher_init_decrypt(&decoinfo->cipher,decoinfo->passphrase,(unsigned char *)params)!=e_success)
+    {
+        decoinfo->error="wrong passphrase";
+        return e_failure;
+    }
+    if(decoinfo->ecc_parity>0)
+    {
+        if(encrypted)
+            cipher_xor(&decoinfo->cipher,secret,size);
+    }
+    else
+    {
+        for(long i=0;i<size;i+=CIPHER_BLOCK_SIZE) // Each block is decrypted right after it is extracted
+        {
+            long n=(size-i<CIPHER_BLOCK_SIZE) ? size-i : CIPHER_BLOCK_SIZE;
+            extract(decoinfo,secret+i,n,cursor);
+            if(encrypted)
+                cipher_xor(&decoinfo->cipher,secret+i,n);
+        }
+    }
+    if(encrypted)
+        cipher_wipe(&decoinfo->cipher);
+    return e_success;
+}
+
+// Function to extract bytes from the stego file
+static void extract_bytes_from_file(DecodeInfo *decoinfo, char *data, long size, void *cursor)
+{
+    (void)cursor; // The file position is the cursor
+    for(long i=0;i<size;i++) // Decode each byte of secret file data
+        data[i]=decode_lsb_to_byte(decoinfo->fptr_stego_image); // Decode byte from LSB
+}
+
+// Function to extract bytes from an image held in memory, cursor points to the next image byte
+static void extract_bytes_from_buffer(DecodeInfo *decoinfo, char *data, long size, void *cursor)
+{
+    (void)decoinfo; // Everything needed is in the cursor
+    const char **pos=cursor;
+    for(long i=0;i<size;i++,*pos+=8) // Decode each byte of secret file data
+        data[i]=decode_byte_from_lsb(*pos);
+}
+
 // Function to decode the secret file extension
 Status decode_secret_file_extn(DecodeInfo *decoinfo)
 {
@@ -218,30 +368,124 @@ Status decode_secret_file_extn(DecodeInfo *decoinfo)
         decoinfo->ext_secret_file[i]=decode_lsb_to_byte(decoinfo->fptr_stego_image); // Decode byte from LSB
     }
     decoinfo->ext_secret_file[4]='\0'; // Null-terminate the string
-    strtok(decoinfo->out_fname,"."); // Remove existing extension from output file name
-    strcat(decoinfo->out_fname,decoinfo->ext_secret_file); // Append decoded extension
-    decoinfo->fptr_output=fopen(decoinfo->out_fname,"w"); // Open output file
     return e_success;
 }
 
-// Function to decode the size of the secret file
+// Function to decode the size of the secret file, then check the header against its copies and the image size
 Status decode_secret_file_size(DecodeInfo *decoinfo)
 {
-    decoinfo->size_file=decode_lsb_to_size(decoinfo->fptr_stego_image); // Decode size from LSB
+    FILE *fptr=decoinfo->fptr_stego_image;
+    decoinfo->size_file=decode_lsb_to_size(fptr); // Decode size from LSB
+    char carriers[STEGO_HEADER_COPIES_SPAN]={0}; // Past the end of a small image the zeros fail the checks
+    long pos=ftell(fptr);
+    if(fread(carriers,1,sizeof(carriers),fptr)<sizeof(carriers))
+        clearerr(fptr);
+    if(decode_stego_header_copies(decoinfo,carriers)!=e_success)
+        return e_failure;
+    if(decoinfo->ecc_parity==0) // No copies, the payload follows the header
+        fseek(fptr,pos,SEEK_SET);
+
+    struct stat st;
+    if(decoinfo->size_file<0 || fstat(fileno(fptr),&st)!=0 || BMP_HEADER_SIZE+get_stego_payload_span(get_decode_payload_size(decoinfo))>st.st_size)
+    {
+        print_error("\n ****************** Erorr : secret size %d exceeds the image ***************❌\n",decoinfo->size_file);
+        return e_failure;
+    }
     return e_success;
 }
 
 // Function to decode the secret file data
 Status decode_secret_file_data(DecodeInfo *decoinfo)
 {
-     char user_str[decoinfo->size_file];
+    char *user_str=malloc(decoinfo->size_file+1);
+    if(user_str==NULL)
+    {
+        print_error("\n********** ERROR : out of memory ***************❌\n");
+        return e_failure;
+    }
+    if(decode_payload(decoinfo,user_str,extract_bytes_from_file,NULL)!=e_success)
+    {
+        print_error("\n********** ERROR : %s ***************❌\n",decoinfo->error);
+        free(user_str);
+        return e_failure;
+    }
+    if(decoinfo->corrected>0)
+        print_status("\n>>>>>>>>>> CORRECTED %ld DAMAGED BYTES <<<<<<<<<<<<✅\n",decoinfo->corrected);
 
-    for(int i=0;i<decoinfo->size_file;i++) // Decode each byte of secret file data
+    // The output is only created once the secret is decoded, a wrong passphrase leaves an existing file alone
+    set_fname_extn(decoinfo->out_fname,sizeof(decoinfo->out_fname),decoinfo->ext_secret_file); // Replace the output extension with the decoded one
+    decoinfo->fptr_output=fopen(decoinfo->out_fname,"w"); // Open output file
+    if(decoinfo->fptr_output==NULL)
     {
-        user_str[i]=decode_lsb_to_byte(decoinfo->fptr_stego_image); // Decode byte from LSB
-        fputc(user_str[i],decoinfo->fptr_output); // Write byte to output file
+        perror("fopen");
+        print_error("ERROR: Unable to open file ❌ %s\n",decoinfo->out_fname);
+        free(user_str);
+        return e_failure;
+    }
+    size_t written=fwrite(user_str,1,decoinfo->size_file,decoinfo->fptr_output); // Write data to output file
+    if(fclose(decoinfo->fptr_output)!=0 || written!=(size_t)decoinfo->size_file) // Write errors show up at the latest on close
+    {
+        perror("fwrite");
+        print_error("ERROR: Unable to write file ❌ %s\n",decoinfo->out_fname);
+        free(user_str);
+        return e_failure;
     }
     user_str[decoinfo->size_file]='\0'; // Null-terminate the string
-    printf("\n->->->THE SECRETE DATA IS : < %s > ",user_str); // Print decoded data
+    print_status("\n->->->THE SECRETE DATA IS : < %s > ",user_str); // Print decoded data
+    free(user_str);
     return e_success;
-}
\ No newline at end of file
+}
+
+// Function to decode a byte from LSB of 8 bytes held in memory
+char decode_byte_from_lsb(const char *image_buffer)
+{
+    char data=0;
+    for(int i=0;i<8;i++) // Iterate through 8 bytes
+        data=data|((image_buffer[i]&1)<<(7-i)); // Set bit in data
+    return data; // Return decoded byte
+}
+
+// Function to decode size from LSB of 32 bytes held in memory
+int decode_size_from_lsb(const char *image_buffer)
+{
+    uint data=0;
+    for(int i=0;i<32;i++) // Iterate through 32 bytes
+        data=data|((uint)(image_buffer[i]&1)<<(31-i)); // Set bit in data
+    return data; // Return decoded size
+}
+
+// Function to decode and validate the stego header of an image held in memory
+Status decode_header_from_buffer(const char *image, DecodeInfo *decoinfo)
+{
+    const char *pos=image+BMP_HEADER_SIZE; // Skip the BMP header
+    char magic_str[sizeof(MAGIC_STRING)];
+
+    decoinfo->size_magic_string=decode_size_from_lsb(pos); // Decode size of magic string
+    pos+=32;
+    if(decoinfo->size_magic_string!=strlen(MAGIC_STRING)) // Not a stego image
+        return e_failure;
+    for(int i=0;i<decoinfo->size_magic_string;i++,pos+=8) // Decode each character of magic string
+        magic_str[i]=decode_byte_from_lsb(pos);
+    if(memcmp(magic_str,MAGIC_STRING,decoinfo->size_magic_string)!=0) // Compare with expected magic string
+        return e_failure;
+
+    decoinfo->size_ext=decode_size_from_lsb(pos); // Decode size of secret file extension
+    pos+=32;
+    for(int i=0;i<STEGO_EXTN_SIZE;i++,pos+=8) // Decode 4 characters of file extension
+        decoinfo->ext_secret_file[i]=decode_byte_from_lsb(pos);
+    decoinfo->ext_secret_file[STEGO_EXTN_SIZE]='\0'; // Null-terminate the string
+
+    decoinfo->size_file=decode_size_from_lsb(pos); // Decode size of secret file
+    if(decode_stego_header_copies(decoinfo,pos+32)!=e_success || decoinfo->size_file<0)
+        return e_failure;
+    return e_success;
+}
+
+// Function to decode the secret file data of an image held in memory
+Status decode_data_from_buffer(const char *image, char *secret, DecodeInfo *decoinfo)
+{
+    const char *pos=image+BMP_HEADER_SIZE+STEGO_HEADER_SIZE; // Secret data follows the stego header
+    if(decoinfo->ecc_parity>0) // and the header copies
+        pos+=STEGO_HEADER_COPIES_SPAN;
+    return decode_payload(decoinfo,secret,extract_bytes_from_buffer,&pos);
+}
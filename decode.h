@@ -2,6 +2,7 @@
 #define DECODE_H
 
 #include "types.h"
+#include "cipher.h"
 
 
  typedef struct  _DECODEInfo
@@ -20,12 +21,27 @@
     int size_file;
 
     int size_magic_string;
+
+    //header flags stored with the extension size
+    uint flags;
+    int ecc_parity;
+    long corrected;
+
+    //passphrase for encrypted secret data
+    char *passphrase;
+    CipherStream cipher;
+
+    //reason of the last payload decoding failure
+    const char *error;
 }DecodeInfo;
 
+/* Extracts size bytes at the cursor of a stego file or an in-memory image */
+typedef void (*ExtractFn)(DecodeInfo *decoinfo, char *data, long size, void *cursor);
+
 /* Decoding function prototype */
 
-/* Read and validate Decode args from argv */
-Status read_and_validate_decode_args(char *argv[], DecodeInfo *decoinfo);
+/* Read and validate the stego and optional output file names */
+Status read_and_validate_decode_args(char *files[], DecodeInfo *decoinfo);
 
 //To Skip bmp header to decode data
 Status skip_bmp_header(FILE *fptr_stego_image);
@@ -57,4 +73,31 @@ Status decode_secret_file_size(DecodeInfo *decoinfo);
 /* Decode secret file  */
 Status decode_secret_file_data(DecodeInfo *decoinfo);
 
+/* Split the decoded extension size field into size and header flags */
+Status decode_stego_flags(DecodeInfo *decoinfo);
+
+/* Number of embedded bytes holding the secret data, including ECC parity */
+long get_decode_payload_size(DecodeInfo *decoinfo);
+
+/* Extract the embedded payload, correct errors and decrypt it into the secret data */
+Status decode_payload(DecodeInfo *decoinfo, char *secret, ExtractFn extract, void *cursor);
+
+/* Decode a byte from LSB of image data held in memory */
+char decode_byte_from_lsb(const char *image_buffer);
+
+/* Decode a size from LSB of image data held in memory */
+int decode_size_from_lsb(const char *image_buffer);
+
+/* Bytes of an image decode_header_from_buffer reads, zero filled past the end of a smaller image */
+#define STEGO_HEADER_BUFFER_SIZE (BMP_HEADER_SIZE + STEGO_HEADER_SIZE + STEGO_HEADER_COPIES_SPAN)
+
+/* Check the header fields against the copies of an ECC image and split off the flags */
+Status decode_stego_header_copies(DecodeInfo *decoinfo, const char *carriers);
+
+/* Decode and validate the stego header of an image held in memory (STEGO_HEADER_BUFFER_SIZE bytes) */
+Status decode_header_from_buffer(const char *image, DecodeInfo *decoinfo);
+
+/* Decode secret file data of an image held in memory */
+Status decode_data_from_buffer(const char *image, char *secret, DecodeInfo *decoinfo);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,409 @@
+/* DOCUMENTATION
+Discription : Delta output format.
+A stego image differs from its cover only in the carrier bytes right after
+the BMP header, so instead of a full copy of the cover only that range is
+stored, together with SHA-256 hashes of the cover and of the stego image.
+With the LSB plane option only the low bit of every modified byte is kept,
+one eighth of the range. The apply command rebuilds the stego image from
+the cover and checks both hashes. Decoding reads the payload straight from
+the delta, the cover is only needed to check that it is the right one.*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "delta.h"
+#include "fileio.h"
+#include "types.h"
+#include "common.h"
+
+// Function to store a number in little endian order
+static void put_le(unsigned char *buf, unsigned long long value, int size)
+{
+    for(int i=0;i<size;i++,value>>=8)
+        buf[i]=value&0xff;
+}
+
+// Function to load a little endian number
+static unsigned long long get_le(const unsigned char *buf, int size)
+{
+    unsigned long long value=0;
+    for(int i=size-1;i>=0;i--)
+        value=(value<<8)|buf[i];
+    return value;
+}
+
+// Function to read and validate apply arguments
+Status read_and_validate_apply_args(char *files[], char *cover_fname, DeltaInfo *deltaInfo)
+{
+    // Check if the cover image file has a .bmp extension
+    if(!has_fname_extn(cover_fname,".bmp"))
+    {
+        print_error("\n.................COVER FILE NAME NOT GIVEN, USE -c cover.bmp..............❓\n");
+        return e_failure;
+    }
+    deltaInfo->src_image_fname=cover_fname;
+
+    if(!has_fname_extn(files[0],DELTA_FILE_EXTN)) // Delta file is mandatory
+    {
+        print_error("\n.................DELTA FILE NAME NOT GIVEN..............❓\n");
+        return e_failure;
+    }
+    deltaInfo->delta_fname=files[0];
+
+    // Validate the output file extension (.bmp) or set a default name
+    if(files[1]!=NULL && !has_fname_extn(files[1],".bmp"))
+    {
+        print_error(">>>>>>>>>>>>>>Output file should be bmp ❌>>>>>>>>>>>>>>\n");
+        return e_failure;
+    }
+    deltaInfo->stego_image_fname=(files[1]!=NULL) ? files[1] : "output.bmp";
+    print_status("\n.......READING AND VALIDATION FILES ARE SUCCESSFULL........✅\n");
+    return e_success;
+}
+
+// Function to get the number of bytes stored for the modified range
+long get_delta_data_size(const DeltaHeader *header)
+{
+    if(header->flags&DELTA_FLAG_LSB_PLANE)
+        return (header->length+7)/8;
+    return header->length;
+}
+
+// Function to map a cover image read-only
+Status open_delta_cover(DeltaInfo *deltaInfo)
+{
+    deltaInfo->fd_src_image=open(deltaInfo->src_image_fname,O_RDONLY);
+    if(deltaInfo->fd_src_image<0)
+    {
+        perror("open");
+        fprintf(stderr, "ERROR: Unable to open file ❌ %s\n", deltaInfo->src_image_fname);
+        return e_failure;
+    }
+    deltaInfo->src_image_size=get_fd_size(deltaInfo->fd_src_image);
+    if(deltaInfo->src_image_size<BMP_HEADER_SIZE)
+    {
+        print_error("\n........Cover image is too small.........❌\n");
+        close(deltaInfo->fd_src_image);
+        return e_failure;
+    }
+    void *map=mmap(NULL,deltaInfo->src_image_size,PROT_READ,MAP_SHARED,deltaInfo->fd_src_image,0);
+    if(map==MAP_FAILED)
+    {
+        perror("mmap");
+        close(deltaInfo->fd_src_image);
+        return e_failure;
+    }
+    deltaInfo->src_image=map;
+    return e_success;
+}
+
+// Function to unmap the cover image
+static void close_delta_cover(DeltaInfo *deltaInfo)
+{
+    if(deltaInfo->src_image==NULL)
+        return;
+    munmap((void *)deltaInfo->src_image,deltaInfo->src_image_size);
+    close(deltaInfo->fd_src_image);
+    deltaInfo->src_image=NULL;
+}
+
+// Function to hash the cover and the stego image it becomes with the modified range
+void hash_delta_images(const char *cover, const DeltaHeader *header, const char *range, unsigned char cover_hash[], unsigned char stego_hash[])
+{
+    Sha256 stego;
+    sha256(cover,header->cover_size,cover_hash);
+    sha256_init(&stego);
+    sha256_update(&stego,cover,header->offset);
+    sha256_update(&stego,range,header->length);
+    sha256_update(&stego,cover+header->offset+header->length,header->cover_size-header->offset-header->length);
+    sha256_final(&stego,stego_hash);
+}
+
+// Function to write the delta header and the modified bytes
+Status write_delta(const char *delta_fname, const DeltaHeader *header, const char *range)
+{
+    unsigned char head[DELTA_HEADER_SIZE];
+    memcpy(head,DELTA_MAGIC,4);
+    put_le(head+4,DELTA_VERSION,2);
+    put_le(head+6,header->flags,2);
+    put_le(head+8,header->cover_size,8);
+    put_le(head+16,header->offset,8);
+    put_le(head+24,header->length,8);
+    memcpy(head+32,header->cover_hash,SHA256_DIGEST_SIZE);
+    memcpy(head+32+SHA256_DIGEST_SIZE,header->stego_hash,SHA256_DIGEST_SIZE);
+
+    long data_size=get_delta_data_size(header);
+    char *data=(char *)range;
+    if(header->flags&DELTA_FLAG_LSB_PLANE) // Pack the LSBs, 8 bytes of the range to a byte
+    {
+        data=calloc(data_size,1);
+        if(data==NULL)
+            return e_failure;
+        for(long i=0;i<header->length;i++)
+            data[i/8]|=(range[i]&1)<<(7-i%8);
+    }
+
+    Status ret=e_failure;
+    int fd=open(delta_fname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if(fd>=0)
+    {
+        if(write_full_at(fd,(char *)head,sizeof(head),0)==e_success && write_full_at(fd,data,data_size,sizeof(head))==e_success)
+            ret=e_success;
+        if(close(fd)!=0)
+            ret=e_failure;
+    }
+    if(data!=range)
+        free(data);
+    return ret;
+}
+
+// Function to read the delta header and its modified bytes, the cover fills the upper bits of an LSB plane
+Status read_delta(DeltaInfo *deltaInfo)
+{
+    DeltaHeader *header=&deltaInfo->header;
+    unsigned char head[DELTA_HEADER_SIZE];
+    int fd=open(deltaInfo->delta_fname,O_RDONLY);
+    if(fd<0)
+    {
+        fprintf(stderr, "ERROR: Unable to open file ❌ %s\n", deltaInfo->delta_fname);
+        return e_failure;
+    }
+    long delta_size=get_fd_size(fd);
+    if(delta_size<DELTA_HEADER_SIZE || read_full_at(fd,(char *)head,sizeof(head),0)!=e_success || memcmp(head,DELTA_MAGIC,4)!=0 || get_le(head+4,2)!=DELTA_VERSION)
+    {
+        print_error("\n****************  ERROR : NOT A DELTA FILE *************❌\n");
+        close(fd);
+        return e_failure;
+    }
+    header->flags=get_le(head+6,2);
+    header->cover_size=get_le(head+8,8);
+    header->offset=get_le(head+16,8);
+    header->length=get_le(head+24,8);
+    memcpy(header->cover_hash,head+32,SHA256_DIGEST_SIZE);
+    memcpy(header->stego_hash,head+32+SHA256_DIGEST_SIZE,SHA256_DIGEST_SIZE);
+
+    // Bounds are checked one by one so crafted 64 bit values cannot overflow the sums
+    if((header->flags&~DELTA_FLAG_LSB_PLANE)!=0 || header->offset<0 || header->length<0 || header->offset>header->cover_size
+       || header->length>header->cover_size-header->offset || header->length>8*delta_size
+       || delta_size!=DELTA_HEADER_SIZE+get_delta_data_size(header))
+    {
+        print_error("\n****************  ERROR : DELTA FILE IS DAMAGED *************❌\n");
+        close(fd);
+        return e_failure;
+    }
+    if(deltaInfo->src_image!=NULL && deltaInfo->src_image_size!=header->cover_size)
+    {
+        print_error("\n****************  ERROR : COVER IMAGE DOES NOT MATCH THE DELTA *************❌\n");
+        close(fd);
+        return e_failure;
+    }
+    long data_size=get_delta_data_size(header);
+
+    deltaInfo->range=malloc(header->length+data_size);
+    if(deltaInfo->range==NULL || read_full_at(fd,deltaInfo->range+header->length,data_size,DELTA_HEADER_SIZE)!=e_success)
+    {
+        print_error("\n****************  ERROR : DELTA FILE COULD NOT BE READ *************❌\n");
+        free(deltaInfo->range);
+        deltaInfo->range=NULL;
+        close(fd);
+        return e_failure;
+    }
+    close(fd);
+
+    const char *data=deltaInfo->range+header->length;
+    if(header->flags&DELTA_FLAG_LSB_PLANE) // Put every bit back under the upper bits of the cover
+    {
+        const char *cover=(deltaInfo->src_image!=NULL) ? deltaInfo->src_image+header->offset : NULL;
+        for(long i=0;i<header->length;i++)
+            deltaInfo->range[i]=((cover!=NULL) ? (cover[i]&~1) : 0)|((data[i/8]>>(7-i%8))&1);
+    }
+    else
+        memcpy(deltaInfo->range,data,header->length);
+    return e_success;
+}
+
+// Function to encode a secret and write only its delta against the cover
+Status do_delta_encoding(EncodeInfo *encInfo)
+{
+    DeltaInfo deltaInfo={0};
+    deltaInfo.src_image_fname=encInfo->src_image_fname;
+    if(open_delta_cover(&deltaInfo)!=e_success)
+    {
+        print_error(">>>>>>>>ERROR : PROBLEM IN OPENING FILES ❌.................\n");
+        return e_failure;
+    }
+    print_status("\n>>>>>> FILE OPENING IS SUCCESSFULL <<<<<<<✅\n");
+
+    // Encode into a private copy of the carrier prefix
+    long prefix;
+    const char *error;
+    char *image=encode_secret_to_prefix(encInfo,deltaInfo.src_image,deltaInfo.src_image_size,&prefix,&error);
+    if(image==NULL)
+    {
+        print_error("\n.............Secret file data not encoded : %s..................❌\n",error);
+        close_delta_cover(&deltaInfo);
+        return e_failure;
+    }
+    print_status("\n >>>>>>>>>> SECRET FILE DATA IS SUCCESSFULLY ENCODED <<<<<<<<<<<<✅\n");
+
+    DeltaHeader *header=&deltaInfo.header;
+    header->flags=encInfo->delta_lsb_plane ? DELTA_FLAG_LSB_PLANE : 0;
+    header->cover_size=deltaInfo.src_image_size;
+    header->offset=BMP_HEADER_SIZE; // Only the carrier bytes after the BMP header change
+    header->length=prefix-BMP_HEADER_SIZE;
+    hash_delta_images(deltaInfo.src_image,header,image+header->offset,header->cover_hash,header->stego_hash);
+    Status ret=write_delta(encInfo->stego_image_fname,header,image+header->offset);
+    if(ret!=e_success)
+        print_error("\n.......Delta file could not be written completely.......❌\n");
+    else
+    {
+        print_status("\n>>>>>>>>>> DELTA OF %ld BYTES WRITTEN FOR A COVER OF %ld BYTES <<<<<<<<<<<<✅\n",DELTA_HEADER_SIZE+get_delta_data_size(header),header->cover_size);
+        if(encInfo->show_stats)
+            print_embed_stats(&encInfo->stats); // Image quality of the stego image
+    }
+    free(image);
+    close_delta_cover(&deltaInfo);
+    return ret;
+}
+
+// Function to rebuild the stego image from the cover and the delta
+Status do_delta_apply(DeltaInfo *deltaInfo)
+{
+    if(open_delta_cover(deltaInfo)!=e_success)
+    {
+        print_error(">>>>>>>>ERROR : PROBLEM IN OPENING FILES ❌.................\n");
+        return e_failure;
+    }
+    Status ret=e_failure;
+    if(read_delta(deltaInfo)!=e_success)
+        goto out;
+
+    // Both hashes must match before anything is written
+    DeltaHeader *header=&deltaInfo->header;
+    unsigned char cover_hash[SHA256_DIGEST_SIZE],stego_hash[SHA256_DIGEST_SIZE];
+    hash_delta_images(deltaInfo->src_image,header,deltaInfo->range,cover_hash,stego_hash);
+    if(memcmp(cover_hash,header->cover_hash,SHA256_DIGEST_SIZE)!=0)
+    {
+        print_error("\n****************  ERROR : COVER IMAGE DOES NOT MATCH THE DELTA *************❌\n");
+        goto out;
+    }
+    if(memcmp(stego_hash,header->stego_hash,SHA256_DIGEST_SIZE)!=0)
+    {
+        print_error("\n****************  ERROR : DELTA FILE IS DAMAGED *************❌\n");
+        goto out;
+    }
+    print_status("\n>>>>>> COVER AND DELTA HASHES ARE MATCHING <<<<<<<✅\n");
+
+    struct stat cover_st,stego_st;
+    if(fstat(deltaInfo->fd_src_image,&cover_st)==0 && stat(deltaInfo->stego_image_fname,&stego_st)==0 && cover_st.st_dev==stego_st.st_dev && cover_st.st_ino==stego_st.st_ino)
+    {
+        print_error("\n......Stego image would overwrite the cover......❌\n");
+        goto out;
+    }
+    int fd=open(deltaInfo->stego_image_fname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if(fd<0)
+    {
+        fprintf(stderr, "ERROR: Unable to open file ❌ %s\n", deltaInfo->stego_image_fname);
+        goto out;
+    }
+    long end=header->offset+header->length;
+    if(clone_range_at(deltaInfo->fd_src_image,deltaInfo->src_image,fd,0,header->offset)==e_success
+       && write_full_at(fd,deltaInfo->range,header->length,header->offset)==e_success
+       && clone_range_at(deltaInfo->fd_src_image,deltaInfo->src_image,fd,end,header->cover_size-end)==e_success)
+        ret=e_success;
+    if(close(fd)!=0)
+        ret=e_failure;
+    if(ret!=e_success)
+        print_error("\n.......Stego image could not be written completely.......❌\n");
+out:
+    free(deltaInfo->range);
+    close_delta_cover(deltaInfo);
+    return ret;
+}
+
+// Function to decode the secret from a delta, the cover is only needed to check its hash
+Status do_delta_decoding(DecodeInfo *decoinfo, char *cover_fname)
+{
+    DeltaInfo deltaInfo={0};
+    deltaInfo.delta_fname=decoinfo->stego_image_fname;
+    deltaInfo.src_image_fname=cover_fname;
+    if(cover_fname!=NULL && open_delta_cover(&deltaInfo)!=e_success)
+        return e_failure;
+
+    Status ret=e_failure;
+    char *image=NULL,*secret=NULL;
+    if(read_delta(&deltaInfo)!=e_success)
+        goto out;
+    DeltaHeader *header=&deltaInfo.header;
+    if(deltaInfo.src_image!=NULL) // Check the cover when it is given
+    {
+        unsigned char cover_hash[SHA256_DIGEST_SIZE],stego_hash[SHA256_DIGEST_SIZE];
+        hash_delta_images(deltaInfo.src_image,header,deltaInfo.range,cover_hash,stego_hash);
+        if(memcmp(cover_hash,header->cover_hash,SHA256_DIGEST_SIZE)!=0 || memcmp(stego_hash,header->stego_hash,SHA256_DIGEST_SIZE)!=0)
+        {
+            print_error("\n****************  ERROR : COVER IMAGE DOES NOT MATCH THE DELTA *************❌\n");
+            goto out;
+        }
+        print_status("\n>>>>>> COVER AND DELTA HASHES ARE MATCHING <<<<<<<✅\n");
+    }
+    if(header->offset!=BMP_HEADER_SIZE || header->length<(long)STEGO_HEADER_SIZE) // Payload must start right after the BMP header
+    {
+        print_error("\n****************  ERROR : DELTA DOES NOT HOLD A STEGO HEADER *************❌\n");
+        goto out;
+    }
+
+    // Only the LSBs are decoded, the BMP header is not needed
+    long image_size=BMP_HEADER_SIZE+header->length;
+    if(image_size<(long)STEGO_HEADER_BUFFER_SIZE) // Room for the header copies
+        image_size=STEGO_HEADER_BUFFER_SIZE;
+    image=calloc(image_size,1);
+    if(image==NULL)
+        goto out;
+    memcpy(image+BMP_HEADER_SIZE,deltaInfo.range,header->length);
+    if(decode_header_from_buffer(image,decoinfo)!=e_success)
+    {
+        print_error("\n****************  ERROR : INVALID MAGIC STRING *************❌\n");
+        goto out;
+    }
+    print_status("\n>>>>><<<<<<<<< DECODING MAGIC STRING IS SUCCESSFULL >>>>>>>>>>>>>>>✅\n");
+    if(get_stego_payload_span(get_decode_payload_size(decoinfo))>header->length)
+    {
+        print_error("\n ****************** Erorr : secret size %d exceeds the delta ***************❌\n",decoinfo->size_file);
+        goto out;
+    }
+    secret=malloc(decoinfo->size_file+1);
+    if(secret==NULL || decode_data_from_buffer(image,secret,decoinfo)!=e_success)
+    {
+        print_error("\n********** ERROR : %s ***************❌\n",(secret!=NULL) ? decoinfo->error : "out of memory");
+        goto out;
+    }
+    if(decoinfo->corrected>0)
+        print_status("\n>>>>>>>>>> CORRECTED %ld DAMAGED BYTES <<<<<<<<<<<<✅\n",decoinfo->corrected);
+
+    set_fname_extn(decoinfo->out_fname,sizeof(decoinfo->out_fname),decoinfo->ext_secret_file); // Replace the output extension with the decoded one
+    int fd=open(decoinfo->out_fname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if(fd<0)
+    {
+        fprintf(stderr, "ERROR: Unable to open file ❌ %s\n", decoinfo->out_fname);
+        goto out;
+    }
+    ret=write_full_at(fd,secret,decoinfo->size_file,0);
+    if(close(fd)!=0)
+        ret=e_failure;
+    if(ret!=e_success)
+    {
+        print_error("\n.......Output file could not be written completely.......❌\n");
+        goto out;
+    }
+    secret[decoinfo->size_file]='\0'; // Null-terminate the string
+    print_status("\n->->->THE SECRETE DATA IS : < %s > ",secret); // Print decoded data
+out:
+    free(secret);
+    free(image);
+    free(deltaInfo.range);
+    close_delta_cover(&deltaInfo);
+    return ret;
+}
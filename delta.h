@@ -0,0 +1,85 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include "types.h"
+#include "encode.h"
+#include "decode.h"
+#include "sha256.h"
+
+/*
+ * Delta file, the bytes of a stego image that differ from its cover.
+ * All numbers are little endian.
+ *   0  "SDLT"
+ *   4  version (16 bit), flags (16 bit)
+ *   8  cover size, offset and length of the modified range (64 bit each)
+ *  32  SHA-256 of the cover, SHA-256 of the stego image
+ *  96  modified bytes, or only their LSBs packed 8 to a byte (MSB first)
+ */
+
+#define DELTA_MAGIC "SDLT"
+#define DELTA_VERSION 1
+#define DELTA_HEADER_SIZE (32 + 2 * SHA256_DIGEST_SIZE)
+#define DELTA_FLAG_LSB_PLANE 0x0001 // Upper 7 bits of every byte come from the cover
+
+typedef struct _DeltaHeader
+{
+    uint flags;
+    long cover_size;
+    long offset;
+    long length;
+    unsigned char cover_hash[SHA256_DIGEST_SIZE];
+    unsigned char stego_hash[SHA256_DIGEST_SIZE];
+} DeltaHeader;
+
+/*
+ * Structure to store information required for
+ * rebuilding a stego image from its cover and delta
+ */
+
+typedef struct _DeltaInfo
+{
+    /* Cover image, mapped */
+    char *src_image_fname;
+    int fd_src_image;
+    const char *src_image;
+    long src_image_size;
+
+    /* Delta file */
+    char *delta_fname;
+    DeltaHeader header;
+    char *range; // Modified bytes as they are in the stego image
+
+    /* Rebuilt stego image */
+    char *stego_image_fname;
+} DeltaInfo;
+
+/* Delta function prototype */
+
+/* Read and validate the delta and optional stego file names, the cover is given with -c */
+Status read_and_validate_apply_args(char *files[], char *cover_fname, DeltaInfo *deltaInfo);
+
+/* Encode a secret and write only its delta against the cover */
+Status do_delta_encoding(EncodeInfo *encInfo);
+
+/* Rebuild the stego image from the cover and the delta */
+Status do_delta_apply(DeltaInfo *deltaInfo);
+
+/* Decode the secret from a delta, the cover is only needed to check its hash */
+Status do_delta_decoding(DecodeInfo *decoinfo, char *cover_fname);
+
+/* Map a cover image read-only */
+Status open_delta_cover(DeltaInfo *deltaInfo);
+
+/* Read the delta header and its modified bytes, the cover fills the upper bits of an LSB plane */
+Status read_delta(DeltaInfo *deltaInfo);
+
+/* Write the delta header and the modified bytes */
+Status write_delta(const char *delta_fname, const DeltaHeader *header, const char *range);
+
+/* Hash the cover and the stego image it becomes with the modified range */
+void hash_delta_images(const char *cover, const DeltaHeader *header, const char *range, unsigned char cover_hash[], unsigned char stego_hash[]);
+
+/* Number of bytes stored for the modified range */
+long get_delta_data_size(const DeltaHeader *header);
+
+#endif
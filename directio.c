@@ -0,0 +1,159 @@
+/* DOCUMENTATION
+Discription : O_DIRECT writer for stego images.
+open_direct_stego() returns a regular FILE (fopencookie) so the encoding
+code keeps using fwrite. Data is gathered into page-aligned blocks of
+DIRECT_IO_BLOCK_SIZE and written with pwrite. The last block is padded to
+the alignment and the file is truncated back to the written size on fclose,
+which fails when that is not the final size the file was opened for.
+Buffers come from a small shared pool and are reused for every output.*/
+#define _GNU_SOURCE // fopencookie, O_DIRECT, fallocate
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "directio.h"
+#include "bufpool.h"
+#include "fileio.h"
+#include "types.h"
+
+typedef struct _DirectWriter
+{
+    int fd;
+    int direct;        // 0 once the filesystem refused O_DIRECT
+    PoolBuffer *buf;
+    size_t used;       // Bytes gathered in buf
+    off_t offset;      // File offset of buf, always aligned
+    off_t final_size;  // Size preallocated and expected on close, 0 if unknown
+} DirectWriter;
+
+static BufferPool direct_pool;
+static pthread_once_t direct_pool_once=PTHREAD_ONCE_INIT;
+static Status direct_pool_status;
+
+// Function to set up the shared pool of aligned blocks once
+static void direct_pool_init(void)
+{
+    direct_pool_status=pool_init(&direct_pool,DIRECT_IO_BUFFERS,DIRECT_IO_BLOCK_SIZE);
+}
+
+// Function to write the gathered block, falling back to buffered I/O if O_DIRECT is refused
+static Status direct_flush(DirectWriter *w)
+{
+    size_t size=(w->used+DIRECT_IO_ALIGN-1)/DIRECT_IO_ALIGN*DIRECT_IO_ALIGN; // O_DIRECT needs whole aligned blocks
+    if(size==0)
+        return e_success;
+    memset(w->buf->data+w->used,0,size-w->used); // Padding is cut off again on close
+    if(write_full_at(w->fd,w->buf->data,size,w->offset)!=e_success)
+    {
+        if(!w->direct || errno!=EINVAL)
+            return e_failure;
+        // Opening with O_DIRECT worked but the filesystem rejects the writes
+        fcntl(w->fd,F_SETFL,fcntl(w->fd,F_GETFL)&~O_DIRECT);
+        w->direct=0;
+        if(write_full_at(w->fd,w->buf->data,size,w->offset)!=e_success)
+            return e_failure;
+    }
+    w->offset+=w->used;
+    w->used=0;
+    return e_success;
+}
+
+// fopencookie write: gather data into the aligned block
+static ssize_t direct_write(void *cookie, const char *data, size_t size)
+{
+    DirectWriter *w=cookie;
+    size_t done=0;
+    while(done<size)
+    {
+        size_t n=DIRECT_IO_BLOCK_SIZE-w->used;
+        if(n>size-done)
+            n=size-done;
+        memcpy(w->buf->data+w->used,data+done,n);
+        w->used+=n;
+        done+=n;
+        if(w->used==DIRECT_IO_BLOCK_SIZE && direct_flush(w)!=e_success)
+            return done>n ? (ssize_t)(done-n) : -1;
+    }
+    return size;
+}
+
+// fopencookie seek: the writer is sequential, only the current position can be asked for
+static int direct_seek(void *cookie, off64_t *offset, int whence)
+{
+    DirectWriter *w=cookie;
+    off_t pos=w->offset+w->used;
+    off_t target=(whence==SEEK_SET) ? *offset : (whence==SEEK_CUR) ? pos+*offset : -1;
+    if(target!=pos)
+    {
+        errno=ESPIPE;
+        return -1;
+    }
+    *offset=pos;
+    return 0;
+}
+
+// fopencookie close: write the last padded block and cut the file to its final size
+static int direct_close(void *cookie)
+{
+    DirectWriter *w=cookie;
+    off_t size=w->offset+w->used;
+    int ret=0;
+    if(direct_flush(w)!=e_success || ftruncate(w->fd,size)!=0)
+        ret=EOF;
+    else if(w->final_size>0 && size!=w->final_size) // Short or long image, do not leave it looking complete
+    {
+        errno=EIO;
+        ret=EOF;
+    }
+    if(close(w->fd)!=0)
+        ret=EOF;
+    pool_release(&direct_pool,w->buf);
+    free(w);
+    return ret;
+}
+
+// Function to open fname for writing final_size bytes bypassing the page cache
+FILE *open_direct_stego(const char *fname, off_t final_size)
+{
+    static const cookie_io_functions_t io={NULL,direct_write,direct_seek,direct_close};
+    pthread_once(&direct_pool_once,direct_pool_init);
+    if(direct_pool_status!=e_success)
+        return NULL;
+
+    DirectWriter *w=calloc(1,sizeof(DirectWriter));
+    if(w==NULL)
+        return NULL;
+    w->final_size=final_size;
+    w->direct=1;
+    w->fd=open(fname,O_WRONLY|O_CREAT|O_TRUNC|O_DIRECT,0644);
+    if(w->fd<0 && errno==EINVAL) // Filesystem does not support O_DIRECT at all
+    {
+        w->direct=0;
+        w->fd=open(fname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    }
+    if(w->fd<0)
+    {
+        free(w);
+        return NULL;
+    }
+    if(final_size>0 && fallocate(w->fd,0,0,final_size)!=0 && errno!=EOPNOTSUPP && errno!=ENOSYS) // Reserve all blocks up front
+    {
+        close(w->fd);
+        free(w);
+        return NULL;
+    }
+
+    w->buf=pool_acquire(&direct_pool,DIRECT_IO_BLOCK_SIZE);
+    FILE *fp=(w->buf!=NULL) ? fopencookie(w,"w",io) : NULL;
+    if(fp==NULL)
+    {
+        if(w->buf!=NULL)
+            pool_release(&direct_pool,w->buf);
+        close(w->fd);
+        free(w);
+    }
+    return fp;
+}
@@ -0,0 +1,23 @@
+#ifndef DIRECTIO_H
+#define DIRECTIO_H
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "types.h"
+
+/*
+ * Stego image writer that bypasses the page cache.
+ * The output is preallocated to its final size and written
+ * with O_DIRECT in large aligned blocks from page-aligned
+ * pool buffers. When the filesystem refuses O_DIRECT the
+ * same blocks are written through the page cache instead.
+ */
+
+#define DIRECT_IO_BLOCK_SIZE (1024 * 1024)
+#define DIRECT_IO_ALIGN 4096
+#define DIRECT_IO_BUFFERS 4
+
+/* Open fname for writing final_size bytes, returns a stdio stream or NULL */
+FILE *open_direct_stego(const char *fname, off_t final_size);
+
+#endif
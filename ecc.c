@@ -0,0 +1,332 @@
+/* DOCUMENTATION
+Discription : Table driven Reed-Solomon RS(255,k) codec used to protect the
+secret file data against flipped image bytes.
+GF(256) uses the polynomial 0x11d and generator 2, the code roots are
+2^0 .. 2^(parity-1). Byte j of every codeword is stored together in the
+interleaved payload, so encoding and the syndromes work on a row of up to
+RS_CHUNK codewords at once : a multiply by a constant is two 16 entry nibble
+lookups (pshufb with SSSE3/AVX2, picked at run time) and an xor. Parity is a
+LFSR over the data rows and the syndromes are Horner's rule over all rows.
+Only codewords with a non zero syndrome go through Berlekamp-Massey, Chien
+search and Forney, which stay scalar.*/
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#include "ecc.h"
+#include "types.h"
+
+static unsigned char gf_exp[512]; // Doubled so gf_exp[a + b] needs no modulo
+static unsigned char gf_log[256];
+static pthread_once_t gf_once=PTHREAD_ONCE_INIT;
+
+static unsigned char gf_mul(unsigned char a, unsigned char b)
+{
+    if(a==0 || b==0)
+        return 0;
+    return gf_exp[gf_log[a]+gf_log[b]];
+}
+
+static unsigned char gf_div(unsigned char a, unsigned char b)
+{
+    if(a==0)
+        return 0;
+    return gf_exp[gf_log[a]+255-gf_log[b]];
+}
+
+// Function to build the split-nibble multiply table of the constant c
+static void gf_nibble_table(unsigned char c, unsigned char *table)
+{
+    for(int i=0;i<16;i++)
+    {
+        table[i]=gf_mul(c,i);
+        table[16+i]=gf_mul(c,i<<4);
+    }
+}
+
+// Region kernel: out[k] = c * a[k] ^ b[k] for the constant of a nibble table, out may be a or b
+static void gf_madd_region_scalar(const unsigned char *table, const unsigned char *a, const unsigned char *b, unsigned char *out, long len)
+{
+    for(long k=0;k<len;k++)
+        out[k]=table[a[k]&15]^table[16+(a[k]>>4)]^b[k];
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Region kernel with SSSE3, 16 bytes per pshufb pair
+__attribute__((target("ssse3")))
+static void gf_madd_region_ssse3(const unsigned char *table, const unsigned char *a, const unsigned char *b, unsigned char *out, long len)
+{
+    const __m128i lo=_mm_loadu_si128((const __m128i *)table);
+    const __m128i hi=_mm_loadu_si128((const __m128i *)(table+16));
+    const __m128i mask=_mm_set1_epi8(0x0f);
+    long k=0;
+    for(;k+16<=len;k+=16)
+    {
+        __m128i x=_mm_loadu_si128((const __m128i *)(a+k));
+        __m128i y=_mm_xor_si128(_mm_shuffle_epi8(lo,_mm_and_si128(x,mask)),_mm_shuffle_epi8(hi,_mm_and_si128(_mm_srli_epi64(x,4),mask)));
+        _mm_storeu_si128((__m128i *)(out+k),_mm_xor_si128(y,_mm_loadu_si128((const __m128i *)(b+k))));
+    }
+    gf_madd_region_scalar(table,a+k,b+k,out+k,len-k);
+}
+
+// Region kernel with AVX2, 32 bytes per vpshufb pair
+__attribute__((target("avx2")))
+static void gf_madd_region_avx2(const unsigned char *table, const unsigned char *a, const unsigned char *b, unsigned char *out, long len)
+{
+    const __m256i lo=_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)table));
+    const __m256i hi=_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)(table+16)));
+    const __m256i mask=_mm256_set1_epi8(0x0f);
+    long k=0;
+    for(;k+32<=len;k+=32)
+    {
+        __m256i x=_mm256_loadu_si256((const __m256i *)(a+k));
+        __m256i y=_mm256_xor_si256(_mm256_shuffle_epi8(lo,_mm256_and_si256(x,mask)),_mm256_shuffle_epi8(hi,_mm256_and_si256(_mm256_srli_epi64(x,4),mask)));
+        _mm256_storeu_si256((__m256i *)(out+k),_mm256_xor_si256(y,_mm256_loadu_si256((const __m256i *)(b+k))));
+    }
+    gf_madd_region_scalar(table,a+k,b+k,out+k,len-k);
+}
+#endif
+
+/* Widest region kernel the CPU runs, set with the tables */
+static void (*gf_madd_region)(const unsigned char *, const unsigned char *, const unsigned char *, unsigned char *, long)=gf_madd_region_scalar;
+
+// Function to build the log/antilog tables of GF(256) and pick the region kernel
+static void gf_init_tables(void)
+{
+    int x=1;
+    for(int i=0;i<255;i++)
+    {
+        gf_exp[i]=x;
+        gf_log[x]=i;
+        x<<=1;
+        if(x&0x100)
+            x^=0x11d;
+    }
+    for(int i=255;i<512;i++)
+        gf_exp[i]=gf_exp[i-255];
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        gf_madd_region=gf_madd_region_avx2;
+    else if(__builtin_cpu_supports("ssse3"))
+        gf_madd_region=gf_madd_region_ssse3;
+#endif
+}
+
+// Function to evaluate a polynomial stored lowest degree first at x
+static unsigned char gf_poly_eval(const unsigned char *poly, int len, unsigned char x)
+{
+    unsigned char y=0;
+    for(int i=len-1;i>=0;i--)
+        y=gf_mul(y,x)^poly[i];
+    return y;
+}
+
+// Function to build generator polynomial and multiply tables for parity bytes per codeword
+Status rs_init(RSCodec *rs, int parity)
+{
+    unsigned char gen[MAX_RS_PARITY+1]; // Highest degree first, gen[0] is 1
+    if(parity<2 || parity>MAX_RS_PARITY)
+        return e_failure;
+    pthread_once(&gf_once,gf_init_tables);
+
+    // gen(x) = (x - 2^0)(x - 2^1)...(x - 2^(parity-1))
+    memset(gen,0,sizeof(gen));
+    gen[0]=1;
+    for(int i=0;i<parity;i++)
+        for(int j=i+1;j>0;j--)
+            gen[j]^=gf_mul(gen[j-1],gf_exp[i]);
+
+    rs->gen_table=malloc(GF_NIBBLE_TABLE*parity);
+    rs->synd_table=malloc(GF_NIBBLE_TABLE*parity);
+    if(rs->gen_table==NULL || rs->synd_table==NULL)
+    {
+        rs_free(rs);
+        return e_failure;
+    }
+    for(int j=0;j<parity;j++)
+    {
+        gf_nibble_table(gen[j+1],rs->gen_table+j*GF_NIBBLE_TABLE);
+        gf_nibble_table(gf_exp[j],rs->synd_table+j*GF_NIBBLE_TABLE);
+    }
+    rs->parity=parity;
+    rs->data_size=RS_BLOCK_SIZE-parity;
+    return e_success;
+}
+
+// Function to free the multiply tables
+void rs_free(RSCodec *rs)
+{
+    free(rs->gen_table);
+    free(rs->synd_table);
+    rs->gen_table=NULL;
+    rs->synd_table=NULL;
+}
+
+// Function to get the size of the interleaved codewords protecting size data bytes
+long rs_encoded_size(int parity, long size)
+{
+    long data_size=RS_BLOCK_SIZE-parity;
+    long blocks=(size+data_size-1)/data_size;
+    return blocks*RS_BLOCK_SIZE;
+}
+
+// Function to compute the parity rows of count codewords whose data rows are stride bytes apart
+static void rs_encode_rows(const RSCodec *rs, unsigned char *rows, long stride, int count)
+{
+    unsigned char ring[MAX_RS_PARITY][RS_CHUNK]; // Parity register j is ring[(head + j) % parity]
+    unsigned char feedback[RS_CHUNK];
+    int n=rs->parity,head=0;
+
+    for(int j=0;j<n;j++)
+        memset(ring[j],0,count);
+    for(int i=0;i<rs->data_size;i++)
+    {
+        const unsigned char *data=rows+i*stride;
+        for(int k=0;k<count;k++)
+            feedback[k]=data[k]^ring[head][k];
+        memset(ring[head],0,count); // Shifted out, becomes the last register
+        for(int j=1;j<=n;j++) // Register j-1 = register j ^ feedback * generator coefficient j
+        {
+            unsigned char *reg=ring[(head+j)%n];
+            gf_madd_region(rs->gen_table+(j-1)*GF_NIBBLE_TABLE,feedback,reg,reg,count);
+        }
+        head=(head+1)%n;
+    }
+    for(int j=0;j<n;j++)
+        memcpy(rows+(rs->data_size+j)*stride,ring[(head+j)%n],count);
+}
+
+// Function to encode data bytes into interleaved codewords
+void rs_encode_payload(const RSCodec *rs, const char *data, long size, char *payload)
+{
+    long blocks=rs_encoded_size(rs->parity,size)/RS_BLOCK_SIZE;
+
+    for(long b=0;b<blocks;b++) // Byte j of codeword b goes to row j
+    {
+        long start=b*rs->data_size;
+        long len=(size-start<rs->data_size) ? size-start : rs->data_size;
+        for(long j=0;j<len;j++)
+            payload[j*blocks+b]=data[start+j];
+        for(long j=len;j<rs->data_size;j++) // Zero pad the last codeword
+            payload[j*blocks+b]=0;
+    }
+    for(long b=0;b<blocks;b+=RS_CHUNK)
+        rs_encode_rows(rs,(unsigned char *)payload+b,blocks,(blocks-b<RS_CHUNK) ? blocks-b : RS_CHUNK);
+}
+
+// Function to correct one codeword in place from its syndromes, returns number of corrected bytes or -1
+static int rs_correct_block(const RSCodec *rs, unsigned char *block, const unsigned char *synd)
+{
+    int n=rs->parity;
+    unsigned char lambda[MAX_RS_PARITY+1]={1},prev[MAX_RS_PARITY+1]={1},temp[MAX_RS_PARITY+1];
+    unsigned char omega[MAX_RS_PARITY];
+
+    // Berlekamp-Massey: error locator lambda(x), lowest degree first
+    int L=0,m=1;
+    unsigned char b=1;
+    for(int r=0;r<n;r++)
+    {
+        unsigned char d=synd[r];
+        for(int i=1;i<=L;i++)
+            d^=gf_mul(lambda[i],synd[r-i]);
+        if(d==0)
+        {
+            m++;
+            continue;
+        }
+        unsigned char coef=gf_div(d,b);
+        memcpy(temp,lambda,sizeof(temp));
+        for(int i=0;i+m<=n;i++)
+            lambda[i+m]^=gf_mul(coef,prev[i]);
+        if(2*L<=r)
+        {
+            L=r+1-L;
+            memcpy(prev,temp,sizeof(prev));
+            b=d;
+            m=1;
+        }
+        else
+            m++;
+    }
+    if(2*L>n)
+        return -1;
+
+    // Error evaluator omega(x) = synd(x) * lambda(x) mod x^n
+    for(int i=0;i<n;i++)
+    {
+        omega[i]=0;
+        for(int j=0;j<=i && j<=L;j++)
+            omega[i]^=gf_mul(synd[i-j],lambda[j]);
+    }
+
+    // Chien search over every power, Forney for the magnitude
+    int found=0;
+    for(int p=0;p<RS_BLOCK_SIZE;p++)
+    {
+        unsigned char x_inv=gf_exp[(255-p)%255]; // X^-1 for an error at x^p
+        if(gf_poly_eval(lambda,L+1,x_inv)!=0)
+            continue;
+        unsigned char deriv=0;
+        for(int i=1;i<=L;i+=2) // Formal derivative keeps the odd terms only
+            deriv^=gf_mul(lambda[i],gf_exp[(gf_log[x_inv]*(i-1))%255]);
+        if(deriv==0)
+            return -1;
+        unsigned char magnitude=gf_mul(gf_exp[p],gf_div(gf_poly_eval(omega,n,x_inv),deriv));
+        block[RS_BLOCK_SIZE-1-p]^=magnitude;
+        found++;
+    }
+    if(found!=L)
+        return -1;
+    return found;
+}
+
+// Function to correct and de-interleave a payload back into data bytes
+Status rs_decode_payload(const RSCodec *rs, const char *payload, long size, char *data, long *corrected)
+{
+    long blocks=rs_encoded_size(rs->parity,size)/RS_BLOCK_SIZE;
+    unsigned char synd[MAX_RS_PARITY][RS_CHUNK];
+    unsigned char block[RS_BLOCK_SIZE],column[MAX_RS_PARITY];
+    const unsigned char *rows=(const unsigned char *)payload;
+    int n=rs->parity;
+
+    *corrected=0;
+    for(long b0=0;b0<blocks;b0+=RS_CHUNK)
+    {
+        int count=(blocks-b0<RS_CHUNK) ? blocks-b0 : RS_CHUNK;
+
+        // Syndromes of count codewords by Horner's rule, row i holds the coefficients of x^(254 - i)
+        for(int j=0;j<n;j++)
+            memset(synd[j],0,count);
+        for(int i=0;i<RS_BLOCK_SIZE;i++)
+            for(int j=0;j<n;j++)
+                gf_madd_region(rs->synd_table+j*GF_NIBBLE_TABLE,synd[j],rows+i*blocks+b0,synd[j],count);
+
+        for(int k=0;k<count;k++)
+        {
+            long b=b0+k;
+            int has_error=0;
+            for(int i=0;i<RS_BLOCK_SIZE;i++)
+                block[i]=rows[i*blocks+b];
+            for(int j=0;j<n;j++)
+            {
+                column[j]=synd[j][k];
+                has_error|=column[j];
+            }
+            if(has_error)
+            {
+                int fixed=rs_correct_block(rs,block,column);
+                if(fixed<0)
+                    return e_failure;
+                *corrected+=fixed;
+            }
+
+            long start=b*rs->data_size;
+            long len=(size-start<rs->data_size) ? size-start : rs->data_size;
+            memcpy(data+start,block,len);
+        }
+    }
+    return e_success;
+}
@@ -0,0 +1,47 @@
+#ifndef ECC_H
+#define ECC_H
+
+#include "types.h"
+
+/*
+ * Reed-Solomon RS(255,k) error correction over GF(256).
+ * The payload is split into blocks of k = 255 - parity bytes,
+ * the last one zero padded, and the codewords are interleaved
+ * byte by byte so a run of damaged image bytes is spread over
+ * all codewords.
+ */
+
+#define RS_BLOCK_SIZE 255
+#define DEFAULT_RS_PARITY 32
+#define MAX_RS_PARITY 128
+
+/* Columns (codewords) handled together by the region multiplies */
+#define RS_CHUNK 256
+
+/* Split-nibble multiply table of a constant c : c * x = t[x & 15] ^ t[16 + (x >> 4)] */
+#define GF_NIBBLE_TABLE 32
+
+typedef struct _RSCodec
+{
+    int parity;                  // Parity bytes per codeword, corrects parity/2 byte errors
+    int data_size;               // Data bytes per codeword
+    unsigned char *gen_table;    // Nibble table j = generator coefficient j+1
+    unsigned char *synd_table;   // Nibble table j = 2^j
+} RSCodec;
+
+/* Build generator polynomial and multiply tables for parity bytes per codeword */
+Status rs_init(RSCodec *rs, int parity);
+
+/* Free the multiply tables */
+void rs_free(RSCodec *rs);
+
+/* Size of the interleaved codewords protecting size data bytes */
+long rs_encoded_size(int parity, long size);
+
+/* Encode size data bytes into rs_encoded_size() interleaved bytes */
+void rs_encode_payload(const RSCodec *rs, const char *data, long size, char *payload);
+
+/* Correct and de-interleave a payload back into size data bytes */
+Status rs_decode_payload(const RSCodec *rs, const char *payload, long size, char *data, long *corrected);
+
+#endif
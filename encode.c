@@ -15,83 +15,169 @@ Secret file data.
 #include "types.h"
 #include "common.h"
 #include<string.h>
-#include<unistd.h>
+#include<math.h>
+#include<stdlib.h>
+#include<sys/stat.h>
+#include "directio.h"
+#include "fileio.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
 
-// Function to check the operation type (encode or decode) based on command-line arguments
-OperationType check_operation_type(char *argv[]){
-   if(! strcmp(argv[1],"-e")) // Check if the argument is "-e" for encoding
-   { 
-        return e_encode; 
-   } 
-    else if(!strcmp(argv[1],"-d")) // Check if the argument is "-d" for decoding
-    {
-       return e_decode;
-    }
-    else if(argv[1]==NULL) // If no argument is provided
-    {
-      printf("ERROR : INVALID ARGUMENTS ...❌\n");
-      return e_unsupported;
-   }
-   else // If the argument is neither "-e" nor "-d"
-   {
-      printf("...............Unsupported type.................❌\n");
-      return e_unsupported;
-    }
-}
+/* Position inside an image held in memory */
+typedef struct
+{
+    char *image;
+    char *pos;
+} BufferCursor;
+
+static void embed_bytes_to_file(EncodeInfo *encInfo, const char *data, long size, void *cursor);
+static void embed_bytes_to_buffer(EncodeInfo *encInfo, const char *data, long size, void *cursor);
 
-// Function to read and validate encoding arguments
-Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo)
+// Function to read and validate encoding file names (cover, secret, optional stego)
+Status read_and_validate_encode_args(char *files[], EncodeInfo *encInfo)
 {
-   // Check if the source image file has a .bmp extension and the secret file has a .txt extension
-   if((strstr(argv[2],".bmp")!= NULL) && (strstr(argv[3],".txt")!=NULL ))
+   // Check if the source image file and the secret file are given
+   if(files[0]==NULL || files[1]==NULL)
    {
-      if(strcmp(strstr(argv[2],".bmp"),".bmp")==0) // Validate .bmp extension
-      {
-         encInfo->src_image_fname=argv[2]; // Set source image file name
-      }
-      else
-      {
-         printf("\n.........Invalid Extensions .............❌\n");
-         return e_failure;
-      }
+      print_error("\n.................SOURCE FILE NAME NOT GIVEN..............❓\n");
+      return e_failure; 
+   }
+
+   // Validate the source image file extension (.bmp)
+   if(has_fname_extn(files[0],".bmp"))
+   {
+      encInfo->src_image_fname=files[0]; // Set source image file name
    }
    else
    {
-      printf("\n.................SOURCE FILE NAME NOT GIVEN..............❓\n");
-      return e_failure; 
+      print_error("\n.........Invalid Extensions .............❌\n");
+      return e_failure;
    }
 
    // Validate the secret file extension (.txt or .c)
-   if((strcmp(strstr(argv[3],".txt"),".txt")==0) || (strcmp(strstr(argv[3],".c"),".c")==0) || (strcmp(strstr(argv[3],".txt"),".txt")==0))
+   if(has_fname_extn(files[1],".txt") || has_fname_extn(files[1],".c"))
    {
-      encInfo->secret_fname=argv[3]; // Set secret file name
+      encInfo->secret_fname=files[1]; // Set secret file name
    }
    else
    {
-      printf(">>>>>>>>>>>>>>>>Invalid Extension................❌\n");
+      print_error(">>>>>>>>>>>>>>>>Invalid Extension................❌\n");
       return e_failure;
    } 
 
-   // Validate the output file extension (.bmp) or set a default name
-   if(argv[4]!=NULL)
+   // Validate the output file extension (.bmp, or .delta for a delta) or set a default name
+   const char *out_extn=encInfo->delta_output ? DELTA_FILE_EXTN : ".bmp";
+   if(files[2]!=NULL)
    {
-      if(strcmp(strstr(argv[4],".bmp"),".bmp")==0)
-         encInfo->stego_image_fname=argv[4]; // Set output file name
+      if(has_fname_extn(files[2],out_extn))
+         encInfo->stego_image_fname=files[2]; // Set output file name
       else
       {
-         printf(">>>>>>>>>>>>>>Output file should be bmp ❌>>>>>>>>>>>>>>");
+         print_error(">>>>>>>>>>>>>>Output file should be %s ❌>>>>>>>>>>>>>>\n",out_extn+1);
          return e_failure;
       }
    }
    else
    {
-      encInfo->stego_image_fname="output.bmp"; // Default output file name
-      printf("\n>>>>>>>>>>>>>>>> The output file is created with name of 'output.bmp'<<<<<<<<<<<✅\n");
+      encInfo->stego_image_fname=encInfo->delta_output ? "output" DELTA_FILE_EXTN : "output.bmp"; // Default output file name
+      print_status("\n>>>>>>>>>>>>>>>> The output file is created with name of '%s'<<<<<<<<<<<✅\n",encInfo->stego_image_fname);
    }
-   printf("\n.......READING AND VALIDATION FILES ARE SUCCESSFULL........✅\n");    
+   print_status("\n.......READING AND VALIDATION FILES ARE SUCCESSFULL........✅\n");    
    return e_success;
 }
 
+// Function to prepare the Reed-Solomon codec when ECC is requested
+Status init_payload_ecc(EncodeInfo *encInfo)
+{
+   if(encInfo->ecc_parity==0)
+      return e_success;
+   return rs_init(&encInfo->rs,encInfo->ecc_parity);
+}
+
+// Function to derive the encryption key when a passphrase is given
+Status init_payload_cipher(EncodeInfo *encInfo)
+{
+   if(encInfo->passphrase==NULL)
+      return e_success;
+   return cipher_init_encrypt(&encInfo->cipher,encInfo->passphrase,encInfo->cipher_params);
+}
+
+// Function to get the number of bytes embedded for the secret data
+long get_payload_size(EncodeInfo *encInfo)
+{
+   long size=encInfo->size_secret_file;
+   if(encInfo->passphrase!=NULL) // Salt, nonce and key check
+      size+=CIPHER_HEADER_SIZE;
+   if(encInfo->ecc_parity>0) // Header copies, then the codewords
+      size=STEGO_HEADER_COPIES*STEGO_HEADER_COPY_SIZE+rs_encoded_size(encInfo->ecc_parity,size);
+   return size;
+}
+
+// Function to encrypt, protect and embed the secret data
+Status encode_payload(EncodeInfo *encInfo, char *secret, EmbedFn embed, void *cursor)
+{
+   long size=encInfo->size_secret_file;
+   if(encInfo->ecc_parity>0) // ECC protects salt, nonce and key check along with the ciphertext, so the whole secret is encrypted first
+   {
+      long header=(encInfo->passphrase!=NULL) ? CIPHER_HEADER_SIZE : 0;
+      long payload_size=rs_encoded_size(encInfo->ecc_parity,header+size);
+      char *payload=malloc(payload_size+header+size); // Codewords, then the bytes they protect
+      if(payload==NULL)
+         return e_failure;
+      char *data=payload+payload_size;
+      memcpy(data,encInfo->cipher_params,header);
+      memcpy(data+header,secret,size);
+      if(encInfo->passphrase!=NULL)
+         cipher_xor(&encInfo->cipher,data+header,size);
+      rs_encode_payload(&encInfo->rs,data,header+size,payload);
+      unsigned char copies[STEGO_HEADER_COPIES][STEGO_HEADER_COPY_SIZE]; // The header is not in the codewords, keep it twice more
+      for(int i=0;i<STEGO_HEADER_COPIES;i++)
+         pack_stego_header_copy(strlen(encInfo->extn_secret_file)|get_stego_flags(encInfo),encInfo->extn_secret_file,size,copies[i]);
+      embed(encInfo,(char *)copies,sizeof(copies),cursor);
+      embed(encInfo,payload,payload_size,cursor);
+      free(payload);
+      return e_success;
+   }
+   if(encInfo->passphrase!=NULL) // Decoder needs salt and nonce before the data
+      embed(encInfo,(char *)encInfo->cipher_params,CIPHER_HEADER_SIZE,cursor);
+   for(long i=0;i<size;i+=CIPHER_BLOCK_SIZE) // Each block is encrypted right before it is embedded
+   {
+      long n=(size-i<CIPHER_BLOCK_SIZE) ? size-i : CIPHER_BLOCK_SIZE;
+      if(encInfo->passphrase!=NULL)
+         cipher_xor(&encInfo->cipher,secret+i,n);
+      embed(encInfo,secret+i,n,cursor);
+   }
+   return e_success;
+}
+
+// Function to pack the extn size field, extn and file size into a header copy, the last 4 bytes are a FNV-1a check of the others
+void pack_stego_header_copy(uint extn_field, const char *extn, uint size, unsigned char *copy)
+{
+   uint check=2166136261u;
+   for(int i=0;i<4;i++) // Big endian, the LSBs read like the 32 bit fields of the header
+   {
+      copy[i]=extn_field>>(24-8*i);
+      copy[4+i]=extn[i];
+      copy[8+i]=size>>(24-8*i);
+   }
+   for(int i=0;i<12;i++)
+      check=(check^copy[i])*16777619u;
+   for(int i=0;i<4;i++)
+      copy[12+i]=check>>(24-8*i);
+}
+
+// Function to get the header flags stored with the secret file extension size
+uint get_stego_flags(EncodeInfo *encInfo)
+{
+   uint flags=0;
+   if(encInfo->ecc_parity>0)
+      flags|=STEGO_FLAG_ECC|((uint)encInfo->ecc_parity<<STEGO_PARITY_SHIFT);
+   if(encInfo->passphrase!=NULL)
+      flags|=STEGO_FLAG_CIPHER;
+   return flags;
+}
+
 /* 
  * Get File pointers for i/p and o/p files
  * Inputs: Src Image file, Secret file and Stego Image file
@@ -118,8 +204,15 @@ Status open_files(EncodeInfo *encInfo)
     	return e_failure;
     }
 
-    // Open stego image file
-    encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "w");
+    // Open stego image file, bypassing the page cache when asked to
+    if(encInfo->direct_io)
+    {
+        struct stat st;
+        off_t size = (fstat(fileno(encInfo->fptr_src_image), &st) == 0) ? st.st_size : 0; // Stego image is as big as the source
+        encInfo->fptr_stego_image = open_direct_stego(encInfo->stego_image_fname, size);
+    }
+    else
+        encInfo->fptr_stego_image = fopen(encInfo->stego_image_fname, "w");
     if (encInfo->fptr_stego_image == NULL) // Check for file open error
     {
     	perror("fopen");
@@ -136,98 +229,115 @@ Status do_encoding(EncodeInfo *encInfo)
    // Open files for encoding
    if(open_files(encInfo)!=e_success)
    {
-      printf(">>>>>>>>ERROR : PROBLEM IN OPENING FILES ❌.................\n");
+      print_error(">>>>>>>>ERROR : PROBLEM IN OPENING FILES ❌.................\n");
+      return e_failure;
+   }
+   print_status("\n>>>>>> FILE OPENING IS SUCCESSFULL <<<<<<<✅\n");
+   if(init_payload_ecc(encInfo)!=e_success)
+   {
+      print_error(">>>>>>>>ERROR : PROBLEM IN PREPARING ECC ❌.................\n");
+      return e_failure;
+   }
+   if(init_payload_cipher(encInfo)!=e_success)
+   {
+      print_error(">>>>>>>>ERROR : PROBLEM IN PREPARING ENCRYPTION ❌.................\n");
       return e_failure;
    }
-   printf("\n>>>>>> FILE OPENING IS SUCCESSFULL <<<<<<<✅\n");
   
-   sleep(5); // Simulate delay
    // Check if the source image has enough capacity to encode the secret file
    if(check_capacity(encInfo)!=e_success) 
    {
-      printf("......Soure file having the less capacity......❌\n");
+      print_error("......Soure file having the less capacity......❌\n");
       return e_failure;
    }
-   printf("\n>>>>>>> FILE CAPACITY CHECKING SUCCESSFULL <<<<<<<✅\n");
+   print_status("\n>>>>>>> FILE CAPACITY CHECKING SUCCESSFULL <<<<<<<✅\n");
+   uint width, height;
+   get_bmp_dimensions(encInfo->fptr_src_image, &width, &height);
+   init_embed_stats(&encInfo->stats, width, height); // Count flipped LSBs while embedding
 
-   sleep(5); // Simulate delay
    // Copy BMP header from source to stego image
    int copybmp=copy_bmp_header(encInfo->fptr_src_image, encInfo->fptr_stego_image);
    int pos1,pos2;
    if(copybmp!=e_success)
    {
-      printf("................header copying is not done..................❌\n");
+      print_error("................header copying is not done..................❌\n");
       return e_failure;
    }
    pos1=ftell(encInfo->fptr_src_image);
    pos2=ftell(encInfo->fptr_stego_image);
    if(pos1==pos2)
-   printf("\n>>>>>>>>>>> BMP HEADER COPIED SUCCESSFULLY <<<<<<<<<<<<<✅\n");
+   print_status("\n>>>>>>>>>>> BMP HEADER COPIED SUCCESSFULLY <<<<<<<<<<<<<✅\n");
 
-   sleep(5); // Simulate delay
    // Encode magic string and its length
    int encode_magic=encode_magic_string(MAGIC_STRING,encInfo);
    if(encode_magic!=e_success)
    {
-    printf("\n.........Magic string length and data not added...........❌\n");
+    print_error("\n.........Magic string length and data not added...........❌\n");
     return e_failure;
    }
    pos1=ftell(encInfo->fptr_src_image);
    pos2=ftell(encInfo->fptr_stego_image);
    if(pos1==pos2)
-   printf("\n>>>>>>>>> MAGICSTRING AND LENGTH OF MAGIC STRING SUCCESSFULLY ENCODED <<<<<<<<<<<<<<✅\n");
+   print_status("\n>>>>>>>>> MAGICSTRING AND LENGTH OF MAGIC STRING SUCCESSFULLY ENCODED <<<<<<<<<<<<<<✅\n");
 
-   sleep(5); // Simulate delay
    // Encode secret file extension and its size
-   char *file_exten = strstr(encInfo->secret_fname,".");
-   int file_e=encode_secret_file_extn(file_exten, encInfo);
+   int file_e=set_secret_file_extn(get_fname_extn(encInfo->secret_fname), encInfo);
+   if(file_e == e_success)
+      file_e=encode_secret_file_extn(encInfo->extn_secret_file, encInfo);
    if(file_e == e_failure)
    {
-        printf("\n.................Encoding of secret file ext and size is not done.............❌\n");
+        print_error("\n.................Encoding of secret file ext and size is not done.............❌\n");
         return e_failure;
    }
    pos1=ftell(encInfo->fptr_src_image);
    pos2=ftell(encInfo->fptr_stego_image);
    if(pos1==pos2)
    {
-      printf("\n>>>>>>>>>ENCODING FILE EXTENSION IS DONE <<<<<<<<<<<<<<<<<<✅\n");
+      print_status("\n>>>>>>>>>ENCODING FILE EXTENSION IS DONE <<<<<<<<<<<<<<<<<<✅\n");
    }
    
    // Encode secret file size
-   sleep(5); // Simulate delay
    int secret_file_size=encode_secret_file_size(encInfo->size_secret_file, encInfo);
    if(secret_file_size != e_success){
-        printf("\n...............Secret file size not encoded................❌\n");
+        print_error("\n...............Secret file size not encoded................❌\n");
         return e_failure;
     }
      pos1=ftell(encInfo->fptr_src_image);
     pos2=ftell(encInfo->fptr_stego_image);
     if(pos1==pos2)
-      printf("\n >>>>>>>>>> SECRET FILE SIZE IS SUCCESSFULLY ENCODED <<<<<<<<<<<<✅\n");
+      print_status("\n >>>>>>>>>> SECRET FILE SIZE IS SUCCESSFULLY ENCODED <<<<<<<<<<<<✅\n");
 
-   sleep(5); // Simulate delay
    // Encode secret file data
    rewind(encInfo->fptr_secret);
    int file_data= encode_secret_file_data(encInfo);
     if(file_data!=e_success){
-      printf("\n.............Secret file data not encoded..................❌\n");
+      print_error("\n.............Secret file data not encoded..................❌\n");
       return e_failure;
     }
     pos1=ftell(encInfo->fptr_src_image);
     pos2=ftell(encInfo->fptr_stego_image);
     if(pos1==pos2)
-    printf("\n >>>>>>>>>> SECRET FILE DATA IS SUCCESSFULLY ENCODED <<<<<<<<<<<<✅\n");
-    sleep(5); // Simulate delay
+    print_status("\n >>>>>>>>>> SECRET FILE DATA IS SUCCESSFULLY ENCODED <<<<<<<<<<<<✅\n");
     // Copy remaining data from source to stego image
    int copy_rem=copy_remaining_img_data(encInfo->fptr_src_image, encInfo->fptr_stego_image);
    if(copy_rem!=e_success){
-      printf("\n.......Remaining data of source file is not copied.......❌\n");
+      print_error("\n.......Remaining data of source file is not copied.......❌\n");
       return e_failure;
    }
    pos1=ftell(encInfo->fptr_src_image);
    pos2=ftell(encInfo->fptr_stego_image);
    if(pos1==pos2)
-      printf("\n>>>>>>>>>>>>>> REMAINING DATA OF SOURCE FILE IS COPIED TO OUTPUT FILE SUCCESSFULLY <<<<<<<<<<<<✅\n");
+      print_status("\n>>>>>>>>>>>>>> REMAINING DATA OF SOURCE FILE IS COPIED TO OUTPUT FILE SUCCESSFULLY <<<<<<<<<<<<✅\n");
+   if(close_files(encInfo)!=e_success)
+   {
+      print_error("\n.......Stego image could not be written completely.......❌\n");
+      return e_failure;
+   }
+   if(encInfo->show_stats)
+      print_embed_stats(&encInfo->stats); // Image quality of the stego image
+   if(encInfo->ecc_parity>0)
+      rs_free(&encInfo->rs);
+   cipher_wipe(&encInfo->cipher);
    return e_success;
 }
 
@@ -238,8 +348,9 @@ Status check_capacity(EncodeInfo *encInfo)
     encInfo->size_secret_file=get_file_size(encInfo->fptr_secret); // Get secret file size
     if(encInfo->size_secret_file==0) // Check if secret file is empty
       return e_failure;
-    else if(encInfo->image_capacity > ((32 + 32 + 4 +sizeof(MAGIC_STRING) + encInfo->size_secret_file)*8)) // Check capacity
+    else if(encInfo->image_capacity > ((32 + 32 + 4 +sizeof(MAGIC_STRING) + get_payload_size(encInfo))*8)) // Check capacity
       return e_success;
+    return e_failure;
 }
 
 // Function to get the size of a file
@@ -249,7 +360,7 @@ uint get_file_size(FILE *fptr)
      int size=ftell(fptr); // Get file size
      if(size==0) // Check if file is empty
      {
-     printf("\n........File is empty.........❌\n");
+     print_error("\n........File is empty.........❌\n");
      return 0;
      }
      return size;
@@ -259,12 +370,18 @@ uint get_file_size(FILE *fptr)
 uint get_image_size_for_bmp(FILE *fptr_image)
 {
     uint width, height;
-    fseek(fptr_image, 18, SEEK_SET); // Move to the 18th byte to read width
-    fread(&width, sizeof(int), 1, fptr_image); // Read width
-    fread(&height, sizeof(int), 1, fptr_image); // Read height
+    get_bmp_dimensions(fptr_image, &width, &height);
     return width * height * 3; // Return image capacity (width * height * 3 bytes per pixel)
 }
 
+/* Function to get the width and height of a BMP image */
+void get_bmp_dimensions(FILE *fptr_image, uint *width, uint *height)
+{
+    fseek(fptr_image, 18, SEEK_SET); // Move to the 18th byte to read width
+    fread(width, sizeof(int), 1, fptr_image); // Read width
+    fread(height, sizeof(int), 1, fptr_image); // Read height
+}
+
 // Function to copy BMP header (54 bytes) from source to destination
 Status copy_bmp_header(FILE * fptr_src_image,FILE *fptr_dest_image)
 {
@@ -281,13 +398,15 @@ Status encode_magic_string(const char *magic_string, EncodeInfo *encInfo)
 {
     int size=strlen(MAGIC_STRING); // Get magic string length
     char brr[32],arr[8];
+    long pos=ftell(encInfo->fptr_src_image); // Image offset, used for embedding statistics
     fread(brr,32,1,encInfo->fptr_src_image); // Read 32 bytes from source
-    encode_size_to_lsb(size,brr); // Encode size into LSB
+    record_lsb_flips(&encInfo->stats,pos,encode_bits_to_lsb(size,32,brr),32); // Encode size into LSB
     fwrite(brr,32,1,encInfo->fptr_stego_image); // Write 32 bytes to stego image
-    for(int i=0;i<size;i++) // Encode each character of magic string
+    pos+=32;
+    for(int i=0;i<size;i++,pos+=8) // Encode each character of magic string
     {
         fread(arr,8,1,encInfo->fptr_src_image); // Read 8 bytes from source
-        encode_byte_to_lsb(magic_string[i], arr); // Encode character into LSB
+        record_lsb_flips(&encInfo->stats,pos,encode_bits_to_lsb((unsigned char)magic_string[i],8,arr),8); // Encode character into LSB
         fwrite(arr,8,1,encInfo->fptr_stego_image); // Write 8 bytes to stego image
     }
     return e_success;
@@ -296,38 +415,181 @@ Status encode_magic_string(const char *magic_string, EncodeInfo *encInfo)
 // Function to encode a byte into LSB of image buffer
 Status encode_byte_to_lsb(char data, char *image_buffer)
 {
-    for(int i=7;i>=0;i--){
-    unsigned char mask=(((unsigned)(data>>i))&1); // Extract bit
-    image_buffer[7-i]=(image_buffer[7-i]&(~1)); // Clear LSB
-    image_buffer[7-i]=(image_buffer[7-i]|mask); // Set LSB
-}
+    encode_bits_to_lsb((unsigned char)data,8,image_buffer);
+    return e_success;
 }
 
 // Function to encode size into LSB of image buffer
 Status encode_size_to_lsb(int data,char *image_buffer){
-    for(int i=31;i>=0;i--)
+    encode_bits_to_lsb(data,32,image_buffer);
+    return e_success;
+}
+
+// Embed kernel: encode nbits of data (MSB first) into LSB and return the mask of flipped bytes
+uint encode_bits_to_lsb(uint data, int nbits, char *image_buffer)
+{
+    uint flips=0;
+    for(int i=0;i<nbits;i++)
     {
-        unsigned char mask=((data>>i)&1); // Extract bit
-        image_buffer[31-i]=(image_buffer[31-i]&(~1)); // Clear LSB
-        image_buffer[31-i]=(image_buffer[31-i]|mask); // Set LSB
+        char bit=(data>>(nbits-1-i))&1; // Extract bit
+        flips|=(uint)((image_buffer[i]^bit)&1)<<i; // Remember whether the LSB changes
+        image_buffer[i]=(image_buffer[i]&(~1))|bit; // Set LSB
     }
+    return flips;
+}
+
+/* LSB of every byte of a 64 bit word */
+#define LSB_WORD_MASK 0x0101010101010101ULL
+
+// Function to spread the bits of a byte into the LSBs of a word, MSB first in memory order
+static inline uint64_t spread_byte_to_lsb(unsigned char data)
+{
+    uint64_t v=data;
+    v=(v|v<<28)&0x0000000F0000000FULL; // Bit i ends up in byte i
+    v=(v|v<<14)&0x0003000300030003ULL;
+    v=(v|v<<7)&LSB_WORD_MASK;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v=__builtin_bswap64(v); // First image byte gets the MSB
+#endif
+    return v;
+}
+
+// Function to sum the bytes of a word, the sum must stay below 256
+static inline unsigned long sum_word_bytes(uint64_t v)
+{
+    return (v*LSB_WORD_MASK)>>56;
+}
+
+// Embed kernel: encode size bytes of data into the LSBs of size*8 image bytes at file offset, 8 image bytes per step
+void embed_bytes_to_lsb(EmbedStats *stats, long offset, const char *data, long size, char *image_buffer)
+{
+    /* Bytes of channel q (byte i with i%3==q) for a word starting at a column of phase 0 */
+    static const uint64_t channel_word[3]={0x00FF0000FF0000FFULL,0xFF0000FF0000FF00ULL,0x0000FF0000FF0000ULL};
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const int little=1;
+#else
+    const int little=0;
+#endif
+    uint64_t flips[3]={0}; // Flipped LSBs per byte lane, one counter per starting column phase
+    long col=(stats->row_size>0) ? (offset-BMP_HEADER_SIZE)%stats->row_size : 0;
+    int words=0;
+
+    for(long i=0;i<size;i++,image_buffer+=8)
+    {
+        uint64_t word,diff;
+        memcpy(&word,image_buffer,8);
+        diff=(word^spread_byte_to_lsb(data[i]))&LSB_WORD_MASK; // LSBs that change
+        word^=diff;
+        memcpy(image_buffer,&word,8);
+        if(stats->row_size>0 && diff!=0)
+        {
+            if(little && col+8<=stats->width*3) // No row padding inside, count per byte lane
+            {
+                flips[col%3]+=diff;
+                words++;
+            }
+            else // Crosses a row end, gather the lanes into a bit mask
+                record_lsb_flips(stats,offset+i*8,(little ? diff : __builtin_bswap64(diff))*0x0102040810204080ULL>>56,8);
+        }
+        if(words==31 || (i==size-1 && words>0)) // Lanes hold at most 31, their sum fits a byte
+        {
+            for(int p=0;p<3;p++)
+            {
+                for(int c=0;c<3;c++)
+                    stats->flipped[c]+=sum_word_bytes(flips[p]&channel_word[(c-p+3)%3]);
+                flips[p]=0;
+            }
+            words=0;
+        }
+        if(stats->row_size>0)
+            for(col+=8;col>=stats->row_size;col-=stats->row_size);
+    }
+}
+
+// Function to reset embedding statistics for an image of width x height pixels
+void init_embed_stats(EmbedStats *stats, uint width, uint height)
+{
+    memset(stats,0,sizeof(*stats));
+    stats->width=width;
+    stats->height=height;
+    stats->row_size=(width*3+3)&~3u; // BMP rows are padded to 4 bytes
+}
+
+// Function to account the flipped LSBs of nbits image bytes starting at file offset
+void record_lsb_flips(EmbedStats *stats, long offset, uint flips, int nbits)
+{
+    /* Bit j of these masks is set when j%3 is 0, 1 or 2 */
+    static const uint channel_mask[3]={0x49249249u,0x92492492u,0x24924924u};
+    if(stats->row_size==0 || flips==0)
+        return;
+    long col=(offset-BMP_HEADER_SIZE)%stats->row_size; // Column of the first byte within its row
+    if(col+nbits<=stats->width*3) // No row padding inside: count each channel with one popcount
+    {
+        int phase=col%3;
+        for(int c=0;c<3;c++)
+            stats->flipped[c]+=__builtin_popcount(flips&channel_mask[(c-phase+3)%3]);
+        return;
+    }
+    for(int j=0;j<nbits;j++,col++) // Crosses a row end, skip padding bytes one by one
+    {
+        if(col==stats->row_size)
+            col=0;
+        if(((flips>>j)&1) && col<stats->width*3)
+            stats->flipped[col%3]++;
+    }
+}
+
+// Function to print MSE, PSNR and the fraction of modified bytes
+void print_embed_stats(const EmbedStats *stats)
+{
+    static const char *channel_name[3]={"BLUE","GREEN","RED"};
+    double channel_bytes=(double)stats->width*stats->height;
+    unsigned long total=stats->flipped[0]+stats->flipped[1]+stats->flipped[2];
+    if(channel_bytes==0)
+        return;
+    // Every change is +-1, so the squared error of the image is the number of flipped LSBs
+    for(int c=0;c<3;c++)
+        printf("\n>>>>> %-5s : MSE %.8f  PSNR %.2f dB\n",channel_name[c],stats->flipped[c]/channel_bytes,get_psnr(stats->flipped[c],channel_bytes));
+    printf("\n>>>>> IMAGE : MSE %.8f  PSNR %.2f dB  MODIFIED BYTES %lu (%.6f%%)\n",total/(3*channel_bytes),get_psnr(total,3*channel_bytes),total,100.0*total/(3*channel_bytes));
+}
+
+// Function to get the PSNR in dB for a squared error summed over the given number of bytes
+double get_psnr(unsigned long squared_error, double bytes)
+{
+    if(squared_error==0)
+        return INFINITY;
+    return 10*log10(255.0*255.0*bytes/squared_error);
+}
+
+// Function to store the secret file extension, zero padded to the STEGO_EXTN_SIZE bytes that are encoded
+Status set_secret_file_extn(const char *extn, EncodeInfo *encInfo)
+{
+   if(extn==NULL) // No extension in the file name
+      extn=".txt";
+   if(strlen(extn)>MAX_FILE_SUFFIX) // Only STEGO_EXTN_SIZE bytes are encoded
+      return e_failure;
+   memset(encInfo->extn_secret_file,0,sizeof(encInfo->extn_secret_file));
+   memcpy(encInfo->extn_secret_file,extn,strlen(extn));
+   return e_success;
 }
 
 // Function to encode secret file extension
 Status encode_secret_file_extn(const char *file_extn, EncodeInfo *encInfo)
 {
-   int size=strlen(file_extn); // Get file extension length
+   uint size=strlen(file_extn)|get_stego_flags(encInfo); // Get file extension length and header flags
    char arr[32];
+   long pos=ftell(encInfo->fptr_src_image); // Image offset, used for embedding statistics
    fread(arr,32,1,encInfo->fptr_src_image); // Read 32 bytes from source
-   encode_size_to_lsb(size,arr); // Encode size into LSB
+   record_lsb_flips(&encInfo->stats,pos,encode_bits_to_lsb(size,32,arr),32); // Encode size into LSB
    fwrite(arr,32,1,encInfo->fptr_stego_image); // Write 32 bytes to stego image
+   pos+=32;
 
    // Encode file extension
    char a[8];
-   for(int i=0;i<4;i++)
+   for(int i=0;i<4;i++,pos+=8)
    {
    fread(a,8,1,encInfo->fptr_src_image); // Read 8 bytes from source
-   encode_byte_to_lsb(file_extn[i],a); // Encode character into LSB
+   record_lsb_flips(&encInfo->stats,pos,encode_bits_to_lsb((unsigned char)file_extn[i],8,a),8); // Encode character into LSB
    fwrite(a,8,1,encInfo->fptr_stego_image); // Write 8 bytes to stego image
    }
    return e_success;
@@ -337,8 +599,9 @@ Status encode_secret_file_extn(const char *file_extn, EncodeInfo *encInfo)
 Status encode_secret_file_size(long file_size, EncodeInfo *encInfo)
 {
     char arr[32];
+    long pos=ftell(encInfo->fptr_src_image); // Image offset, used for embedding statistics
     fread(arr,32,1,encInfo->fptr_src_image); // Read 32 bytes from source
-    encode_size_to_lsb(file_size ,arr); // Encode size into LSB
+    record_lsb_flips(&encInfo->stats,pos,encode_bits_to_lsb(file_size,32,arr),32); // Encode size into LSB
     fwrite(arr,32,1,encInfo->fptr_stego_image); // Write 32 bytes to stego image
     return e_success;
 }
@@ -347,23 +610,166 @@ Status encode_secret_file_size(long file_size, EncodeInfo *encInfo)
 Status encode_secret_file_data(EncodeInfo *encInfo)
 {
    int size=encInfo->size_secret_file; // Get secret file size
-   char arr[size],a[8];
+   char arr[size];
+   long pos=ftell(encInfo->fptr_src_image); // Image offset, used for embedding statistics
    fread(arr,size,1,encInfo->fptr_secret); // Read secret file data
-   for(int i=0;i<size;i++) // Encode each byte of secret file
+   return encode_payload(encInfo,arr,embed_bytes_to_file,&pos);
+}
+
+// Function to embed bytes into the stego file, cursor is the image offset
+static void embed_bytes_to_file(EncodeInfo *encInfo, const char *data, long size, void *cursor)
+{
+   long *pos=cursor;
+   char a[8*512];
+   for(long i=0;i<size;i+=512) // Encode the secret file 512 bytes at a time
    {
-      fread(a,8,1,encInfo->fptr_src_image); // Read 8 bytes from source
-      encode_byte_to_lsb(arr[i],a); // Encode byte into LSB
-      fwrite(a,8,1,encInfo->fptr_stego_image); // Write 8 bytes to stego image
+      long n=(size-i<512) ? size-i : 512;
+      fread(a,8*n,1,encInfo->fptr_src_image); // Read 8 bytes per secret byte from source
+      embed_bytes_to_lsb(&encInfo->stats,*pos,data+i,n,a); // Encode bytes into LSB
+      fwrite(a,8*n,1,encInfo->fptr_stego_image); // Write them to stego image
+      *pos+=8*n;
    }
-    return e_success;
 }
 
 // Function to copy remaining image data from source to stego image
 Status copy_remaining_img_data(FILE *fptr_src, FILE *fptr_dest)
 {
-    char ch;
-   while( (fread(&ch,1,1,fptr_src))){ // Read each byte from source
-    fwrite(&ch,1,1,fptr_dest); // Write each byte to destination
+    char buf[64 * 1024];
+    size_t n;
+    while((n=fread(buf,1,sizeof(buf),fptr_src))>0) // Read a block from source
+    {
+        if(fwrite(buf,1,n,fptr_dest)!=n) // Write the block to destination
+            return e_failure;
     }
-    return e_success;
-}
\ No newline at end of file
+    return ferror(fptr_src) ? e_failure : e_success;
+}
+
+// Function to close all files, the stego image is only complete once it is closed
+Status close_files(EncodeInfo *encInfo)
+{
+    fclose(encInfo->fptr_src_image);
+    fclose(encInfo->fptr_secret);
+    return fclose(encInfo->fptr_stego_image)==0 ? e_success : e_failure;
+}
+
+// Function to get the size of a BMP image whose header is already in memory
+uint get_image_size_for_bmp_buffer(const char *image)
+{
+    uint width, height;
+    get_bmp_dimensions_buffer(image, &width, &height);
+    return width * height * 3; // Return image capacity (width * height * 3 bytes per pixel)
+}
+
+// Function to get the width and height of a BMP image whose header is already in memory
+void get_bmp_dimensions_buffer(const char *image, uint *width, uint *height)
+{
+    memcpy(width, image + 18, sizeof(int)); // Width is at the 18th byte
+    memcpy(height, image + 22, sizeof(int)); // Height follows the width
+}
+
+// Function to get the number of image bytes after the BMP header used to hide a payload
+long get_stego_payload_span(long size_payload)
+{
+    return STEGO_HEADER_SIZE + size_payload * 8;
+}
+
+// Function to encode the whole stego payload into an image held in memory
+Status encode_secret_to_buffer(char *image, char *secret, EncodeInfo *encInfo)
+{
+    char *pos = image + BMP_HEADER_SIZE; // Payload starts right after the BMP header
+    EmbedStats *stats = &encInfo->stats;
+    int size = strlen(MAGIC_STRING);
+    record_lsb_flips(stats, pos - image, encode_bits_to_lsb(size, 32, pos), 32); // Encode magic string size
+    pos += 32;
+    for(int i=0;i<size;i++,pos+=8) // Encode each character of magic string
+        record_lsb_flips(stats, pos - image, encode_bits_to_lsb((unsigned char)MAGIC_STRING[i], 8, pos), 8);
+
+    uint extn_size = strlen(encInfo->extn_secret_file) | get_stego_flags(encInfo);
+    record_lsb_flips(stats, pos - image, encode_bits_to_lsb(extn_size, 32, pos), 32); // Encode extn size and header flags
+    pos += 32;
+    for(int i=0;i<STEGO_EXTN_SIZE;i++,pos+=8) // Encode file extension
+        record_lsb_flips(stats, pos - image, encode_bits_to_lsb((unsigned char)encInfo->extn_secret_file[i], 8, pos), 8);
+
+    record_lsb_flips(stats, pos - image, encode_bits_to_lsb(encInfo->size_secret_file, 32, pos), 32); // Encode secret file size
+    pos += 32;
+    BufferCursor cursor = {image, pos};
+    return encode_payload(encInfo, secret, embed_bytes_to_buffer, &cursor);
+}
+
+// Function to encode the secret file into a private copy of the cover prefix, NULL on failure
+char *encode_secret_to_prefix(EncodeInfo *encInfo, const char *cover, long cover_size, long *prefix_size, const char **error)
+{
+    if(set_secret_file_extn(get_fname_extn(encInfo->secret_fname),encInfo)!=e_success)
+    {
+        *error="secret extension is too long";
+        return NULL;
+    }
+
+    // Read the secret
+    int secret_fd=open(encInfo->secret_fname,O_RDONLY);
+    if(secret_fd<0)
+    {
+        *error="cannot open secret";
+        return NULL;
+    }
+    long secret_size=get_fd_size(secret_fd);
+    char *secret=(secret_size>0) ? malloc(secret_size) : NULL;
+    Status ret=(secret!=NULL) ? read_full_at(secret_fd,secret,secret_size,0) : e_failure;
+    close(secret_fd);
+    if(ret!=e_success)
+    {
+        *error=(secret_size<=0) ? "secret is empty" : "cannot read secret";
+        free(secret);
+        return NULL;
+    }
+    encInfo->size_secret_file=secret_size;
+
+    // Check if the cover has enough capacity to encode the secret
+    encInfo->image_capacity=get_image_size_for_bmp_buffer(cover);
+    long prefix=BMP_HEADER_SIZE+get_stego_payload_span(get_payload_size(encInfo));
+    if(encInfo->image_capacity<prefix-BMP_HEADER_SIZE || cover_size<prefix)
+    {
+        *error="cover has too little capacity";
+        free(secret);
+        return NULL;
+    }
+    if(init_payload_ecc(encInfo)!=e_success)
+    {
+        *error="cannot prepare ecc";
+        free(secret);
+        return NULL;
+    }
+
+    char *image=NULL;
+    if(init_payload_cipher(encInfo)!=e_success)
+        *error="cannot prepare encryption";
+    else if((image=malloc(prefix))==NULL)
+        *error="out of memory";
+    else
+    {
+        uint width,height;
+        memcpy(image,cover,prefix);
+        get_bmp_dimensions_buffer(cover,&width,&height);
+        init_embed_stats(&encInfo->stats,width,height); // Count flipped LSBs while embedding
+        if(encode_secret_to_buffer(image,secret,encInfo)!=e_success)
+        {
+            *error="out of memory";
+            free(image);
+            image=NULL;
+        }
+    }
+    *prefix_size=prefix;
+    free(secret);
+    if(encInfo->ecc_parity>0)
+        rs_free(&encInfo->rs);
+    cipher_wipe(&encInfo->cipher);
+    return image;
+}
+
+// Function to embed bytes into an image held in memory
+static void embed_bytes_to_buffer(EncodeInfo *encInfo, const char *data, long size, void *cursor)
+{
+    BufferCursor *cur = cursor;
+    embed_bytes_to_lsb(&encInfo->stats, cur->pos - cur->image, data, size, cur->pos); // Encode secret data into LSB
+    cur->pos += size * 8;
+}
@@ -2,6 +2,8 @@
 #define ENCODE_H
 
 #include "types.h" // Contains user defined types
+#include "ecc.h"
+#include "cipher.h"
 
 /* 
  * Structure to store information required for
@@ -14,6 +16,19 @@
 #define MAX_IMAGE_BUF_SIZE (MAX_SECRET_BUF_SIZE * 8)
 #define MAX_FILE_SUFFIX 4
 
+/*
+ * Embedding statistics, gathered while encoding.
+ * Every changed byte differs by 1, so the squared
+ * error of a channel is its count of flipped LSBs.
+ */
+typedef struct _EmbedStats
+{
+    uint width;
+    uint height;
+    uint row_size;
+    unsigned long flipped[3]; // Blue, green, red
+} EmbedStats;
+
 typedef struct _EncodeInfo
 {
     /* Source Image info */
@@ -26,7 +41,7 @@ typedef struct _EncodeInfo
     /* Secret File Info */
     char *secret_fname;
     FILE *fptr_secret;
-    char extn_secret_file[MAX_FILE_SUFFIX];
+    char extn_secret_file[MAX_FILE_SUFFIX+1]; // Zero padded, NUL terminated
     char secret_data[MAX_SECRET_BUF_SIZE];
     long size_secret_file;
 
@@ -34,16 +49,56 @@ typedef struct _EncodeInfo
     char *stego_image_fname;
     FILE *fptr_stego_image;
 
+    /* Image quality of the stego image */
+    EmbedStats stats;
+
+    /* Reed-Solomon parity bytes per codeword, 0 disables ECC */
+    int ecc_parity;
+    RSCodec rs;
+
+    /* ChaCha20 encryption of the secret data, NULL passphrase disables it */
+    char *passphrase;
+    unsigned char cipher_params[CIPHER_HEADER_SIZE];
+    CipherStream cipher;
+
+    /* Write the stego image with O_DIRECT */
+    int direct_io;
+
+    /* Print MSE and PSNR after encoding */
+    int show_stats;
+
+    /* Write a delta against the cover instead of a stego image */
+    int delta_output;
+    int delta_lsb_plane; // Keep only the LSBs of the modified bytes
+
 } EncodeInfo;
 
 
 /* Encoding function prototype */
 
-/* Check operation type */
-OperationType check_operation_type(char *argv[]);
+/* Read and validate the cover, secret and optional stego file names */
+Status read_and_validate_encode_args(char *files[], EncodeInfo *encInfo);
+
+/* Prepare the Reed-Solomon codec when ECC is requested */
+Status init_payload_ecc(EncodeInfo *encInfo);
+
+/* Derive the encryption key when a passphrase is given */
+Status init_payload_cipher(EncodeInfo *encInfo);
+
+/* Embeds size bytes at the cursor of a stego file or an in-memory image */
+typedef void (*EmbedFn)(EncodeInfo *encInfo, const char *data, long size, void *cursor);
+
+/* Encrypt, protect and embed the secret data, the secret is encrypted in place */
+Status encode_payload(EncodeInfo *encInfo, char *secret, EmbedFn embed, void *cursor);
+
+/* Number of bytes embedded for the secret data, including ECC parity and header copies */
+long get_payload_size(EncodeInfo *encInfo);
+
+/* Pack extn size field, extn (4 bytes) and file size with a check word into STEGO_HEADER_COPY_SIZE bytes */
+void pack_stego_header_copy(uint extn_field, const char *extn, uint size, unsigned char *copy);
 
-/* Read and validate Encode args from argv */
-Status read_and_validate_encode_args(char *argv[], EncodeInfo *encInfo);
+/* Header flags stored with the secret file extension size */
+uint get_stego_flags(EncodeInfo *encInfo);
 
 /* Perform the encoding */
 Status do_encoding(EncodeInfo *encInfo);
@@ -57,6 +112,9 @@ Status check_capacity(EncodeInfo *encInfo);
 /* Get image size */
 uint get_image_size_for_bmp(FILE *fptr_image);
 
+/* Get image width and height */
+void get_bmp_dimensions(FILE *fptr_image, uint *width, uint *height);
+
 /* Get file size */
 uint get_file_size(FILE *fptr);
 
@@ -74,6 +132,27 @@ Status encode_byte_to_lsb(char data, char *image_buffer);
 
 Status encode_size_to_lsb(int data,char *image_buff);
 
+/* Embed kernel, encode nbits of data into LSB and return mask of flipped bytes */
+uint encode_bits_to_lsb(uint data, int nbits, char *image_buffer);
+
+/* Embed kernel, encode size bytes of data into the LSBs of size*8 image bytes and count the flips */
+void embed_bytes_to_lsb(EmbedStats *stats, long offset, const char *data, long size, char *image_buffer);
+
+/* Reset embedding statistics for an image */
+void init_embed_stats(EmbedStats *stats, uint width, uint height);
+
+/* Account flipped LSBs of nbits image bytes at file offset */
+void record_lsb_flips(EmbedStats *stats, long offset, uint flips, int nbits);
+
+/* Print MSE, PSNR and modified byte fraction */
+void print_embed_stats(const EmbedStats *stats);
+
+/* PSNR in dB for a squared error summed over bytes */
+double get_psnr(unsigned long squared_error, double bytes);
+
+/* Store the secret file extension, NULL gives .txt, longer than MAX_FILE_SUFFIX fails */
+Status set_secret_file_extn(const char *extn, EncodeInfo *encInfo);
+
 /* Encode secret file extenstion */
 Status encode_secret_file_extn(const char *file_extn, EncodeInfo *encInfo);
 
@@ -86,6 +165,24 @@ Status encode_secret_file_data(EncodeInfo *encInfo);
 /* Copy remaining image bytes from src to stego image after encoding */
 Status copy_remaining_img_data(FILE *fptr_src, FILE *fptr_dest);
 
+/* Close i/p and o/p files */
+Status close_files(EncodeInfo *encInfo);
+
+/* Get image size from a BMP header held in memory */
+uint get_image_size_for_bmp_buffer(const char *image);
+
+/* Get image width and height from a BMP header held in memory */
+void get_bmp_dimensions_buffer(const char *image, uint *width, uint *height);
+
+/* Number of image bytes after the BMP header modified when encoding a payload */
+long get_stego_payload_span(long size_payload);
+
+/* Encode magic string, extn, size and secret data into an image held in memory, secret is encrypted in place */
+Status encode_secret_to_buffer(char *image, char *secret, EncodeInfo *encInfo);
+
+/* Read the secret file and encode it into a malloc'd copy of the cover prefix, NULL and *error on failure */
+char *encode_secret_to_prefix(EncodeInfo *encInfo, const char *cover, long cover_size, long *prefix_size, const char **error);
+
 
 
 #endif
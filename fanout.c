@@ -0,0 +1,232 @@
+/* DOCUMENTATION
+Discription : Fan-out encoding, one cover image and many secrets.
+The cover is opened and mapped once. For every secret only the carrier
+prefix (BMP header plus the bytes holding the payload) is copied out of
+the mapping and encoded in memory. That prefix is written to the stego
+image, and the unmodified tail is copied from the cover with
+copy_file_range, which clones the extents on filesystems that support it.
+The secrets are shared out to a few worker threads. The cost is the
+payloads plus the tail copies, the cover is never read once per output.*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "fanout.h"
+#include "encode.h"
+#include "fileio.h"
+#include "types.h"
+#include "common.h"
+
+// Function to read and validate fan-out arguments
+Status read_and_validate_fanout_args(char *cover_fname, char *secret_fnames[], int num_secrets, char *output_dir, FanoutInfo *fanInfo)
+{
+    // Check if the cover image file has a .bmp extension
+    if(!has_fname_extn(cover_fname,".bmp"))
+    {
+        print_error("\n.................SOURCE FILE NAME NOT GIVEN..............❓\n");
+        return e_failure;
+    }
+    fanInfo->src_image_fname=cover_fname;
+
+    if(num_secrets<=0) // At least one secret is needed
+    {
+        print_error("\n.................SECRET FILE NAMES NOT GIVEN..............❓\n");
+        return e_failure;
+    }
+    for(int i=0;i<num_secrets;i++) // Secrets are .txt or .c files like an encoded one
+    {
+        if(!has_fname_extn(secret_fnames[i],".txt") && !has_fname_extn(secret_fnames[i],".c"))
+        {
+            print_error(">>>>>>>>>>>>>>>>Invalid Extension of %s................❌\n",secret_fnames[i]);
+            return e_failure;
+        }
+    }
+    fanInfo->secret_fnames=secret_fnames;
+    fanInfo->num_secrets=num_secrets;
+    fanInfo->output_dir=(output_dir!=NULL) ? output_dir : ".";
+
+    fanInfo->results=calloc(num_secrets,sizeof(FanoutResult));
+    if(fanInfo->results==NULL)
+        return e_failure;
+    for(int i=0;i<num_secrets;i++) // Output is <output dir>/<secret name>.bmp
+    {
+        const char *name=strrchr(secret_fnames[i],'/');
+        name=(name!=NULL) ? name+1 : secret_fnames[i];
+        const char *extn=strrchr(name,'.');
+        int name_len=(extn!=NULL && extn!=name) ? (int)(extn-name) : (int)strlen(name);
+        FanoutResult *res=&fanInfo->results[i];
+        if(snprintf(res->stego_image_fname,sizeof(res->stego_image_fname),"%s/%.*s.bmp",fanInfo->output_dir,name_len,name)>=(int)sizeof(res->stego_image_fname))
+        {
+            print_error("\n.................Output file name too long for %s..............❌\n",secret_fnames[i]);
+            free(fanInfo->results);
+            fanInfo->results=NULL;
+            return e_failure;
+        }
+        for(int j=0;j<i;j++) // Two secrets with the same name would overwrite each other
+        {
+            if(strcmp(fanInfo->results[j].stego_image_fname,res->stego_image_fname)==0)
+            {
+                print_error("\n.................%s and %s give the same output %s..............❌\n",secret_fnames[j],secret_fnames[i],res->stego_image_fname);
+                free(fanInfo->results);
+                fanInfo->results=NULL;
+                return e_failure;
+            }
+        }
+    }
+    print_status("\n.......READING AND VALIDATION FILES ARE SUCCESSFULL........✅\n");
+    return e_success;
+}
+
+// Function to map the cover image and read its dimensions
+Status open_fanout_cover(FanoutInfo *fanInfo)
+{
+    fanInfo->fd_src_image=open(fanInfo->src_image_fname,O_RDONLY);
+    if(fanInfo->fd_src_image<0)
+    {
+        perror("open");
+        fprintf(stderr, "ERROR: Unable to open file ❌ %s\n", fanInfo->src_image_fname);
+        return e_failure;
+    }
+    fanInfo->src_image_size=get_fd_size(fanInfo->fd_src_image);
+    if(fanInfo->src_image_size<BMP_HEADER_SIZE)
+    {
+        print_error("\n........Cover image is too small.........❌\n");
+        close(fanInfo->fd_src_image);
+        return e_failure;
+    }
+    void *map=mmap(NULL,fanInfo->src_image_size,PROT_READ,MAP_SHARED,fanInfo->fd_src_image,0);
+    if(map==MAP_FAILED)
+    {
+        perror("mmap");
+        close(fanInfo->fd_src_image);
+        return e_failure;
+    }
+    fanInfo->src_image=map;
+    get_bmp_dimensions_buffer(fanInfo->src_image,&fanInfo->width,&fanInfo->height);
+    return e_success;
+}
+
+// Function to encode one secret, only the carrier prefix is built in memory
+Status encode_fanout_secret(FanoutInfo *fanInfo, int index)
+{
+    FanoutResult *res=&fanInfo->results[index];
+    EncodeInfo encInfo={0};
+    encInfo.secret_fname=fanInfo->secret_fnames[index];
+    encInfo.stego_image_fname=res->stego_image_fname;
+    encInfo.ecc_parity=fanInfo->ecc_parity;
+    encInfo.passphrase=fanInfo->passphrase;
+
+    // Encode into a private copy of the carrier prefix
+    long prefix;
+    char *image=encode_secret_to_prefix(&encInfo,fanInfo->src_image,fanInfo->src_image_size,&prefix,&res->error);
+    res->size_secret_file=encInfo.size_secret_file;
+    if(image==NULL)
+        return e_failure;
+    int stego_fd=-1;
+    Status ret=e_failure;
+
+    // Write the prefix, then clone the shared tail of the cover
+    struct stat cover_st,stego_st;
+    if(fstat(fanInfo->fd_src_image,&cover_st)==0 && stat(res->stego_image_fname,&stego_st)==0 && cover_st.st_dev==stego_st.st_dev && cover_st.st_ino==stego_st.st_ino)
+    {
+        res->error="stego image would overwrite the cover";
+        goto out;
+    }
+    stego_fd=open(res->stego_image_fname,O_WRONLY|O_CREAT|O_TRUNC,0644);
+    if(stego_fd<0)
+    {
+        res->error="cannot create stego image";
+        goto out;
+    }
+    if(write_full_at(stego_fd,image,prefix,0)!=e_success || clone_range_at(fanInfo->fd_src_image,fanInfo->src_image,stego_fd,prefix,fanInfo->src_image_size-prefix)!=e_success)
+    {
+        res->error="write failed";
+        goto out;
+    }
+    if(close(stego_fd)!=0)
+    {
+        stego_fd=-1;
+        res->error="write failed";
+        goto out;
+    }
+    stego_fd=-1;
+    res->flipped=encInfo.stats.flipped[0]+encInfo.stats.flipped[1]+encInfo.stats.flipped[2];
+    res->psnr=get_psnr(res->flipped,3.0*fanInfo->width*fanInfo->height);
+    ret=e_success;
+out:
+    if(stego_fd>=0)
+        close(stego_fd);
+    free(image);
+    return ret;
+}
+
+// Function run by each worker, encodes secrets until none are left
+static void *fanout_worker(void *arg)
+{
+    FanoutInfo *fanInfo=arg;
+    for(;;)
+    {
+        pthread_mutex_lock(&fanInfo->lock);
+        int index=fanInfo->next_secret++;
+        pthread_mutex_unlock(&fanInfo->lock);
+        if(index>=fanInfo->num_secrets)
+            break;
+        fanInfo->results[index].status=encode_fanout_secret(fanInfo,index);
+    }
+    return NULL;
+}
+
+// Function to perform the fan-out encoding
+Status do_fanout(FanoutInfo *fanInfo)
+{
+    if(open_fanout_cover(fanInfo)!=e_success)
+    {
+        print_error(">>>>>>>>ERROR : PROBLEM IN OPENING FILES ❌.................\n");
+        free(fanInfo->results);
+        return e_failure;
+    }
+    print_status("\n>>>>>> COVER IMAGE MAPPED, %d SECRETS TO ENCODE <<<<<<<✅\n",fanInfo->num_secrets);
+
+    if(fanInfo->num_workers<=0) // One worker per CPU unless given
+    {
+        long cpus=sysconf(_SC_NPROCESSORS_ONLN);
+        fanInfo->num_workers=(cpus>0) ? (cpus<MAX_FANOUT_WORKERS ? cpus : MAX_FANOUT_WORKERS) : 1;
+    }
+    if(fanInfo->num_workers>fanInfo->num_secrets)
+        fanInfo->num_workers=fanInfo->num_secrets;
+
+    pthread_t workers[MAX_FANOUT_WORKERS];
+    int started=0;
+    fanInfo->next_secret=0;
+    pthread_mutex_init(&fanInfo->lock,NULL);
+    for(;started<fanInfo->num_workers && started<MAX_FANOUT_WORKERS;started++)
+        if(pthread_create(&workers[started],NULL,fanout_worker,fanInfo)!=0)
+            break;
+    if(started==0) // No threads, encode everything here
+        fanout_worker(fanInfo);
+    for(int i=0;i<started;i++)
+        pthread_join(workers[i],NULL);
+    pthread_mutex_destroy(&fanInfo->lock);
+
+    int failed=0;
+    for(int i=0;i<fanInfo->num_secrets;i++) // Report in the order the secrets were given
+    {
+        FanoutResult *res=&fanInfo->results[i];
+        if(res->status!=e_success)
+        {
+            print_error("\n......%s : %s......❌\n",fanInfo->secret_fnames[i],res->error);
+            failed++;
+        }
+        else if(fanInfo->show_stats) // Asked for, so printed with -q too like the -e statistics
+            printf("\n>>>>> %s -> %s : %ld BYTES  MODIFIED BYTES %lu  PSNR %.2f dB\n",fanInfo->secret_fnames[i],res->stego_image_fname,res->size_secret_file,res->flipped,res->psnr);
+        else
+            print_status("\n>>>>> %s -> %s ✅\n",fanInfo->secret_fnames[i],res->stego_image_fname);
+    }
+    munmap((void *)fanInfo->src_image,fanInfo->src_image_size);
+    close(fanInfo->fd_src_image);
+    free(fanInfo->results);
+    return (failed==0) ? e_success : e_failure;
+}
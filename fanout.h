@@ -0,0 +1,70 @@
+#ifndef FANOUT_H
+#define FANOUT_H
+
+#include <pthread.h>
+#include <limits.h>
+#include "types.h"
+
+/* Default number of encoding threads is the number of online CPUs, capped at this */
+#define MAX_FANOUT_WORKERS 64
+
+/*
+ * Result of one secret of a fan-out run
+ */
+
+typedef struct _FanoutResult
+{
+    char stego_image_fname[PATH_MAX];
+    Status status;
+    const char *error;
+    long size_secret_file;
+    unsigned long flipped;
+    double psnr;
+} FanoutResult;
+
+/*
+ * Structure to store information required for
+ * encoding many secrets into one cover image
+ */
+
+typedef struct _FanoutInfo
+{
+    /* Cover image, mapped once and shared by all outputs */
+    char *src_image_fname;
+    int fd_src_image;
+    const char *src_image;
+    long src_image_size;
+    uint width, height;
+
+    /* Secrets, one stego image is written per secret */
+    char **secret_fnames;
+    int num_secrets;
+    char *output_dir;
+    FanoutResult *results;
+
+    /* Options shared by every output */
+    int ecc_parity;
+    char *passphrase;
+    int show_stats;
+
+    /* Workers take the next secret until none are left */
+    int num_workers;
+    int next_secret;
+    pthread_mutex_t lock;
+} FanoutInfo;
+
+/* Fan-out function prototype */
+
+/* Read and validate the cover, the secrets and the optional output directory */
+Status read_and_validate_fanout_args(char *cover_fname, char *secret_fnames[], int num_secrets, char *output_dir, FanoutInfo *fanInfo);
+
+/* Perform the fan-out encoding */
+Status do_fanout(FanoutInfo *fanInfo);
+
+/* Map the cover image and read its dimensions */
+Status open_fanout_cover(FanoutInfo *fanInfo);
+
+/* Encode one secret, only the carrier prefix is built in memory */
+Status encode_fanout_secret(FanoutInfo *fanInfo, int index);
+
+#endif
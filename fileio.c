@@ -0,0 +1,143 @@
+/* DOCUMENTATION
+Discription : Descriptor based file helpers.
+pread/pwrite wrappers that retry short transfers and EINTR, the
+sequential fallbacks for pipes and sockets, and the naming of files.*/
+#define _GNU_SOURCE // copy_file_range
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "fileio.h"
+#include "types.h"
+
+// Function to read exactly size bytes at offset, retrying short reads
+Status read_full_at(int fd, char *buf, size_t size, off_t offset)
+{
+    while(size>0)
+    {
+        ssize_t n=pread(fd,buf,size,offset);
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<=0)
+            return e_failure;
+        buf+=n;
+        size-=n;
+        offset+=n;
+    }
+    return e_success;
+}
+
+// Function to write exactly size bytes at offset, retrying short writes
+Status write_full_at(int fd, const char *buf, size_t size, off_t offset)
+{
+    while(size>0)
+    {
+        ssize_t n=pwrite(fd,buf,size,offset);
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<=0)
+            return e_failure;
+        buf+=n;
+        size-=n;
+        offset+=n;
+    }
+    return e_success;
+}
+
+// Function to write a whole file through a descriptor, pipes and sockets are written in order and not truncated
+Status write_whole_fd(int fd, const char *buf, size_t size)
+{
+    if(lseek(fd,0,SEEK_CUR)>=0)
+        return (write_full_at(fd,buf,size,0)==e_success && ftruncate(fd,size)==0) ? e_success : e_failure;
+    while(size>0)
+    {
+        ssize_t n=write(fd,buf,size);
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<=0)
+            return e_failure;
+        buf+=n;
+        size-=n;
+    }
+    return e_success;
+}
+
+// Function to copy a pipe or socket into a memory file so it can be read at offsets, returns the new descriptor or -1
+int spool_fd(int fd)
+{
+    int mem_fd=memfd_create("spool",MFD_CLOEXEC);
+    if(mem_fd<0)
+        return -1;
+    char buf[64*1024];
+    off_t size=0;
+    for(;;)
+    {
+        ssize_t n=read(fd,buf,sizeof(buf));
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n==0)
+            return mem_fd;
+        if(n<0 || write_full_at(mem_fd,buf,n,size)!=e_success)
+            break;
+        size+=n;
+    }
+    close(mem_fd);
+    return -1;
+}
+
+// Function to get the size of the file behind a descriptor
+long get_fd_size(int fd)
+{
+    struct stat st;
+    if(fstat(fd,&st)!=0)
+        return -1;
+    return st.st_size;
+}
+
+// Function to copy size bytes at offset between two files, the rest is written from in_map when the kernel cannot copy
+Status clone_range_at(int in_fd, const char *in_map, int out_fd, off_t offset, off_t size)
+{
+    loff_t src_off=offset,dst_off=offset;
+    off_t end=offset+size;
+    while(src_off<end) // Copied or cloned inside the kernel
+    {
+        ssize_t n=copy_file_range(in_fd,&src_off,out_fd,&dst_off,end-src_off,0);
+        if(n>0)
+            continue;
+        if(n<0 && errno==EINTR)
+            continue;
+        if(n<0 && errno!=EXDEV && errno!=ENOSYS && errno!=EINVAL && errno!=EOPNOTSUPP)
+            return e_failure;
+        break; // Not supported between these files
+    }
+    if(src_off<end)
+        return write_full_at(out_fd,in_map+src_off,end-src_off,src_off);
+    return e_success;
+}
+
+// Function to replace the extension of a file name in place, from the last dot of its base name, leading dots do not start one
+void set_fname_extn(char *fname, size_t size, const char *extn)
+{
+    char *base=strrchr(fname,'/');
+    base=(base!=NULL) ? base+1 : fname;
+    base+=strspn(base,".");
+    char *dot=strrchr(base,'.');
+    size_t len=(dot!=NULL) ? (size_t)(dot-fname) : strlen(fname);
+    snprintf(fname+len,size-len,"%s",extn);
+}
+
+// Function to get the extension of a file name from the last dot of its base name, NULL if it has none
+const char *get_fname_extn(const char *fname)
+{
+    const char *base=strrchr(fname,'/');
+    return strrchr((base!=NULL) ? base+1 : fname,'.');
+}
+
+// Function to check that a file name ends with the given extension, a NULL name has none
+int has_fname_extn(const char *fname, const char *extn)
+{
+    const char *found=(fname!=NULL) ? get_fname_extn(fname) : NULL;
+    return found!=NULL && strcmp(found,extn)==0;
+}
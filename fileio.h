@@ -0,0 +1,36 @@
+#ifndef FILEIO_H
+#define FILEIO_H
+
+#include <sys/types.h>
+#include "types.h"
+
+/* Descriptor based file helpers shared by daemon, update, fan-out and delta modes */
+
+/* Read exactly size bytes at offset */
+Status read_full_at(int fd, char *buf, size_t size, off_t offset);
+
+/* Write exactly size bytes at offset */
+Status write_full_at(int fd, const char *buf, size_t size, off_t offset);
+
+/* Write buf as the whole file, truncated after it, a pipe or socket just gets the bytes */
+Status write_whole_fd(int fd, const char *buf, size_t size);
+
+/* Copy a pipe or socket to its end into a memory file, the new descriptor or -1 */
+int spool_fd(int fd);
+
+/* Copy size bytes at offset with copy_file_range, falling back to a write from in_map */
+Status clone_range_at(int in_fd, const char *in_map, int out_fd, off_t offset, off_t size);
+
+/* Get the size of the file behind a descriptor, -1 on error */
+long get_fd_size(int fd);
+
+/* Replace the extension after the last dot of the base name ("sub.d/out.bin" -> "sub.d/out.txt"), fname holds size bytes */
+void set_fname_extn(char *fname, size_t size, const char *extn);
+
+/* Get the extension of fname from the last dot of its base name ("a.b.txt" -> ".txt"), NULL if it has none */
+const char *get_fname_extn(const char *fname);
+
+/* Check that fname ends with extn after its last dot, 0 for a NULL fname */
+int has_fname_extn(const char *fname, const char *extn);
+
+#endif
@@ -0,0 +1,169 @@
+/* DOCUMENTATION
+Discription : SHA-256 (FIPS 180-4) with HMAC and PBKDF2 on top of it.
+Used to derive the payload encryption key from a passphrase.*/
+#include <string.h>
+#include "sha256.h"
+
+static const uint32_t k[64]=
+{
+    0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+    0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+    0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+    0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+    0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+    0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+    0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+    0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+};
+
+#define ROTR(x,n) (((x)>>(n))|((x)<<(32-(n))))
+
+// Function to hash one 64 byte block into the state
+static void sha256_block(uint32_t state[8], const unsigned char *block)
+{
+    uint32_t w[64],a,b,c,d,e,f,g,h;
+    for(int i=0;i<16;i++)
+        w[i]=(uint32_t)block[4*i]<<24|(uint32_t)block[4*i+1]<<16|(uint32_t)block[4*i+2]<<8|block[4*i+3];
+    for(int i=16;i<64;i++)
+    {
+        uint32_t s0=ROTR(w[i-15],7)^ROTR(w[i-15],18)^(w[i-15]>>3);
+        uint32_t s1=ROTR(w[i-2],17)^ROTR(w[i-2],19)^(w[i-2]>>10);
+        w[i]=w[i-16]+s0+w[i-7]+s1;
+    }
+    a=state[0]; b=state[1]; c=state[2]; d=state[3];
+    e=state[4]; f=state[5]; g=state[6]; h=state[7];
+    for(int i=0;i<64;i++)
+    {
+        uint32_t t1=h+(ROTR(e,6)^ROTR(e,11)^ROTR(e,25))+((e&f)^(~e&g))+k[i]+w[i];
+        uint32_t t2=(ROTR(a,2)^ROTR(a,13)^ROTR(a,22))+((a&b)^(a&c)^(b&c));
+        h=g; g=f; f=e; e=d+t1;
+        d=c; c=b; b=a; a=t1+t2;
+    }
+    state[0]+=a; state[1]+=b; state[2]+=c; state[3]+=d;
+    state[4]+=e; state[5]+=f; state[6]+=g; state[7]+=h;
+}
+
+// Function to start a new hash
+void sha256_init(Sha256 *ctx)
+{
+    static const uint32_t iv[8]={0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19};
+    memcpy(ctx->state,iv,sizeof(iv));
+    ctx->length=0;
+    ctx->used=0;
+}
+
+// Function to hash size more bytes
+void sha256_update(Sha256 *ctx, const void *data, size_t size)
+{
+    const unsigned char *p=data;
+    ctx->length+=size;
+    if(ctx->used>0) // Fill up a partial block first
+    {
+        size_t n=SHA256_BLOCK_SIZE-ctx->used<size ? SHA256_BLOCK_SIZE-ctx->used : size;
+        memcpy(ctx->block+ctx->used,p,n);
+        ctx->used+=n;
+        p+=n;
+        size-=n;
+        if(ctx->used<SHA256_BLOCK_SIZE)
+            return;
+        sha256_block(ctx->state,ctx->block);
+        ctx->used=0;
+    }
+    for(;size>=SHA256_BLOCK_SIZE;p+=SHA256_BLOCK_SIZE,size-=SHA256_BLOCK_SIZE) // Whole blocks straight from the input
+        sha256_block(ctx->state,p);
+    memcpy(ctx->block,p,size);
+    ctx->used=size;
+}
+
+// Function to finish the hash and write the digest
+void sha256_final(Sha256 *ctx, unsigned char digest[SHA256_DIGEST_SIZE])
+{
+    uint64_t bits=ctx->length*8;
+    unsigned char pad[SHA256_BLOCK_SIZE+8]={0x80};
+    size_t pad_size=(ctx->used<56) ? 56-ctx->used : 120-ctx->used;
+    for(int i=0;i<8;i++)
+        pad[pad_size+i]=bits>>(56-8*i);
+    sha256_update(ctx,pad,pad_size+8);
+    for(int i=0;i<8;i++)
+    {
+        digest[4*i]=ctx->state[i]>>24;
+        digest[4*i+1]=ctx->state[i]>>16;
+        digest[4*i+2]=ctx->state[i]>>8;
+        digest[4*i+3]=ctx->state[i];
+    }
+}
+
+// Function to hash a whole buffer
+void sha256(const void *data, size_t size, unsigned char digest[SHA256_DIGEST_SIZE])
+{
+    Sha256 ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx,data,size);
+    sha256_final(&ctx,digest);
+}
+
+// Function to start the inner and outer hashes of HMAC for a key
+static void hmac_sha256_init(Sha256 *inner, Sha256 *outer, const char *key, size_t key_size)
+{
+    unsigned char pad[SHA256_BLOCK_SIZE]={0};
+    if(key_size>SHA256_BLOCK_SIZE) // Long keys are hashed first
+        sha256(key,key_size,pad);
+    else
+        memcpy(pad,key,key_size);
+    for(int i=0;i<SHA256_BLOCK_SIZE;i++)
+        pad[i]^=0x36;
+    sha256_init(inner);
+    sha256_update(inner,pad,SHA256_BLOCK_SIZE);
+    for(int i=0;i<SHA256_BLOCK_SIZE;i++)
+        pad[i]^=0x36^0x5c;
+    sha256_init(outer);
+    sha256_update(outer,pad,SHA256_BLOCK_SIZE);
+}
+
+// Function to compute the HMAC-SHA256 of a whole buffer (RFC 2104)
+void hmac_sha256(const void *key, size_t key_size, const void *data, size_t size, unsigned char digest[SHA256_DIGEST_SIZE])
+{
+    Sha256 inner,outer;
+    hmac_sha256_init(&inner,&outer,key,key_size);
+    sha256_update(&inner,data,size);
+    sha256_final(&inner,digest);
+    sha256_update(&outer,digest,SHA256_DIGEST_SIZE);
+    sha256_final(&outer,digest);
+}
+
+// Function to derive out_size bytes of key material from a passphrase (RFC 8018)
+void pbkdf2_hmac_sha256(const char *passphrase, size_t pass_size, const unsigned char *salt, size_t salt_size,
+                        uint32_t iterations, unsigned char *out, size_t out_size)
+{
+    Sha256 inner,outer,ctx;
+    unsigned char u[SHA256_DIGEST_SIZE],t[SHA256_DIGEST_SIZE];
+    hmac_sha256_init(&inner,&outer,passphrase,pass_size); // Keyed states are reused for every iteration
+
+    for(uint32_t block=1;out_size>0;block++)
+    {
+        unsigned char index[4]={block>>24,block>>16,block>>8,block};
+        ctx=inner;
+        sha256_update(&ctx,salt,salt_size);
+        sha256_update(&ctx,index,4);
+        sha256_final(&ctx,u);
+        ctx=outer;
+        sha256_update(&ctx,u,SHA256_DIGEST_SIZE);
+        sha256_final(&ctx,u);
+        memcpy(t,u,SHA256_DIGEST_SIZE);
+        for(uint32_t i=1;i<iterations;i++)
+        {
+            ctx=inner;
+            sha256_update(&ctx,u,SHA256_DIGEST_SIZE);
+            sha256_final(&ctx,u);
+            ctx=outer;
+            sha256_update(&ctx,u,SHA256_DIGEST_SIZE);
+            sha256_final(&ctx,u);
+            for(int j=0;j<SHA256_DIGEST_SIZE;j++)
+                t[j]^=u[j];
+        }
+        size_t n=out_size<SHA256_DIGEST_SIZE ? out_size : SHA256_DIGEST_SIZE;
+        memcpy(out,t,n);
+        out+=n;
+        out_size-=n;
+    }
+}
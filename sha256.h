@@ -0,0 +1,39 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* SHA-256, HMAC-SHA256 and PBKDF2-HMAC-SHA256 */
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_BLOCK_SIZE 64
+
+typedef struct _Sha256
+{
+    uint32_t state[8];
+    uint64_t length;
+    unsigned char block[SHA256_BLOCK_SIZE];
+    size_t used;
+} Sha256;
+
+/* Start a new hash */
+void sha256_init(Sha256 *ctx);
+
+/* Hash size more bytes */
+void sha256_update(Sha256 *ctx, const void *data, size_t size);
+
+/* Finish the hash and write the digest */
+void sha256_final(Sha256 *ctx, unsigned char digest[SHA256_DIGEST_SIZE]);
+
+/* Hash a whole buffer */
+void sha256(const void *data, size_t size, unsigned char digest[SHA256_DIGEST_SIZE]);
+
+/* HMAC-SHA256 of a whole buffer */
+void hmac_sha256(const void *key, size_t key_size, const void *data, size_t size, unsigned char digest[SHA256_DIGEST_SIZE]);
+
+/* Derive out_size bytes of key material from a passphrase */
+void pbkdf2_hmac_sha256(const char *passphrase, size_t pass_size, const unsigned char *salt, size_t salt_size,
+                        uint32_t iterations, unsigned char *out, size_t out_size);
+
+#endif
@@ -6,65 +6,135 @@ designed to encode secret data into BMP images and decode the hidden data from s
 The tool uses the Least Significant Bit (LSB) technique to embed secret information (such as text files) into the pixel data of BMP images without visibly altering the image. 
 It also supports decoding the hidden data from the stego image.*/
 #include <stdio.h>
+#include <string.h>
 #include "encode.h"
 #include "decode.h"
+#include "daemon.h"
+#include "update.h"
+#include "fanout.h"
+#include "delta.h"
 #include "types.h"
-#include <unistd.h>
+#include "common.h"
+#include "cli.h"
+#include "fileio.h"
 
 int main(int argc, char *argv[])
 {
-    EncodeInfo encInfo;  // Structure to hold encoding information
-    DecodeInfo decoInfo; // Structure tKo hold decoding information
+    CliInfo cli;               // Parsed command line
+    EncodeInfo encInfo={0};    // Structure to hold encoding information
+    DecodeInfo decoInfo={0};   // Structure to hold decoding information
+    DaemonInfo daemonInfo={0}; // Structure to hold daemon information
+    UpdateInfo updInfo={0};    // Structure to hold update information
+    FanoutInfo fanInfo={0};    // Structure to hold fan-out information
+    DeltaInfo deltaInfo={0};   // Structure to hold delta apply information
 
-    // Check the operation type (encode or decode) based on command-line arguments
-    int ret = check_operation_type(argv);
+    // Read the operation type and the options from the command line
+    int ret=read_cli_args(argc, argv, &cli);
+    if (ret != EXIT_OK)
+        return ret;
 
-    if (ret == e_encode) // If the operation is encoding
+    if (cli.mode == e_encode) // If the operation is encoding
     {
-        printf("\n>>>>>>>>>>>>>> ENCODING STARTED <<<<<<<<<<<<<<✅\n");
-        sleep(5); // Simulate a delay (for effect or debugging)
-        // Read and validate encoding arguments from command line
-        int ret1 = read_and_validate_encode_args(argv, &encInfo);
-        if (ret1 != e_success) // If validation fails
+        print_status("\n>>>>>>>>>>>>>> ENCODING STARTED <<<<<<<<<<<<<<✅\n");
+        encInfo.delta_output = cli.delta_output;
+        encInfo.delta_lsb_plane = cli.delta_lsb_plane;
+        // Validate the cover, secret and stego file names
+        if (read_and_validate_encode_args(cli.files, &encInfo) != e_success) // If validation fails
         {
-            printf("\n.............Encoding Process failed due to improper filenames..............❌\n");
-            return e_failure; // Exit with failure status
-        }        
+            print_error("\n.............Encoding Process failed due to improper filenames..............❌\n");
+            return EXIT_USAGE;
+        }
+        encInfo.ecc_parity = cli.ecc_parity;
+        encInfo.passphrase = cli.passphrase;
+        encInfo.direct_io = cli.direct_io;
+        encInfo.show_stats = cli.show_stats;
 
-        // Perform the encoding process
-        ret1 = do_encoding(&encInfo);
-        if (ret1 == e_success) // If encoding is successful
+        // Perform the encoding process, or write only the delta against the cover
+        if ((encInfo.delta_output ? do_delta_encoding(&encInfo) : do_encoding(&encInfo)) != e_success)
+            return EXIT_FAILED;
+        print_status("\n>>>>>>>>>>>>>>>>> ENCODING PROCESS IS COMPLETED SUCCESSFULLY <<<<<<<<<<<<<<<<<<✅\n");
+    }
+    else if (cli.mode == e_decode) // If the operation is decoding
+    {
+        print_status("\n>>>>>>>>>>>>>> DECODING STARTED <<<<<<<<<<<<<<✅\n");
+        // Validate the stego and output file names
+        if (read_and_validate_decode_args(cli.files, &decoInfo) != e_success) // If validation fails
         {
-            printf("\n..........................................loading 🔃...................................................\n");
-            sleep(5); // Simulate a delay (for effect or debugging)
-            printf("\n>>>>>>>>>>>>>>>>> ENCODING PROCESS IS COMPLETED SUCCESSFULLY <<<<<<<<<<<<<<<<<<✅\n");
+            print_error("\n...............Decoding Process failed due to improper filenames.....................❌\n");
+            return EXIT_USAGE;
         }
-    }
+        decoInfo.passphrase = cli.passphrase;
 
-    else if (ret == e_decode) // If the operation is decoding
+        // Perform the decoding process, a delta is decoded without rebuilding the image
+        int is_delta = has_fname_extn(decoInfo.stego_image_fname, DELTA_FILE_EXTN);
+        if (!is_delta && cli.cover_fname != NULL)
+        {
+            print_error("\n...............A cover is only needed to decode a delta.....................❌\n");
+            return EXIT_USAGE;
+        }
+        if ((is_delta ? do_delta_decoding(&decoInfo, cli.cover_fname) : do_decoding(&decoInfo)) != e_success)
+            return EXIT_FAILED;
+        print_status("\n>>>>>>>>>>>>>>>>> DECODING PROCESS IS COMPLETED SUCCESSFULLY <<<<<<<<<<<<<<<<<<✅\n");
+    }
+    else if (cli.mode == e_daemon) // If the operation is serving requests over a socket
+    {
+        // Validate the socket path and number of workers
+        if (read_and_validate_daemon_args(cli.files, &daemonInfo) != e_success) // If validation fails
+        {
+            print_error("\n...............Daemon failed to start due to improper arguments.....................❌\n");
+            return EXIT_USAGE;
+        }
+        // Serve requests until interrupted
+        if (run_daemon(&daemonInfo) != e_success)
+            return EXIT_FAILED;
+    }
+    else if (cli.mode == e_update) // If the operation is updating a stego image in place
     {
-        printf("\n>>>>>>>>>>>>>> DECODING STARTED <<<<<<<<<<<<<<✅\n");
-        // Read and validate decoding arguments from command line
-        sleep(5);
-        int ret2 = read_and_validate_decode_args(argv, &decoInfo);
-        if (ret2 != e_success) // If validation fails
+        print_status("\n>>>>>>>>>>>>>> UPDATE STARTED <<<<<<<<<<<<<<✅\n");
+        // Validate the stego, secret and offset arguments
+        if (read_and_validate_update_args(cli.files, &updInfo) != e_success) // If validation fails
         {
-            printf("\n...............Decoding Process failed due to improper filenames.....................❌\n");
-            return e_failure; // Exit with failure status
+            print_error("\n...............Update Process failed due to improper filenames.....................❌\n");
+            return EXIT_USAGE;
         }
-        // Perform the decoding process
-        ret2 = do_decoding(&decoInfo);
-        if (ret2 == e_success) // If decoding is successful
+        // Perform the update process
+        if (do_update(&updInfo) != e_success)
+            return EXIT_FAILED;
+        print_status("\n>>>>>>>>>>>>>>>>> UPDATE PROCESS IS COMPLETED SUCCESSFULLY <<<<<<<<<<<<<<<<<<✅\n");
+    }
+    else if (cli.mode == e_fanout) // If one cover is encoded with many secrets
+    {
+        print_status("\n>>>>>>>>>>>>>> FAN-OUT ENCODING STARTED <<<<<<<<<<<<<<✅\n");
+        // Validate the cover, the secrets and the output directory
+        if (read_and_validate_fanout_args(cli.files[0], cli.secret_fnames, cli.num_secrets, cli.output_fname, &fanInfo) != e_success) // If validation fails
         {
-            printf("\n..........................................loading 🔃...................................................\n");
-            sleep(5); // Simulate a delay (for effect or debugging)
-            printf("\n>>>>>>>>>>>>>>>>> DECODING PROCESS IS COMPLETED SUCCESSFULLY <<<<<<<<<<<<<<<<<<✅\n");
+            print_error("\n.............Fan-out Process failed due to improper filenames..............❌\n");
+            return EXIT_USAGE;
         }
+        fanInfo.ecc_parity = cli.ecc_parity;
+        fanInfo.passphrase = cli.passphrase;
+        fanInfo.show_stats = cli.show_stats;
+        fanInfo.num_workers = cli.num_workers;
+
+        // Perform the fan-out encoding
+        if (do_fanout(&fanInfo) != e_success)
+            return EXIT_FAILED;
+        print_status("\n>>>>>>>>>>>>>>>>> FAN-OUT ENCODING IS COMPLETED SUCCESSFULLY <<<<<<<<<<<<<<<<<<✅\n");
     }
-    else
+    else if (cli.mode == e_apply) // If a stego image is rebuilt from its cover and delta
     {
-        printf("\n**** ERROR : INVALID INPUTS *******❌\n" );
+        print_status("\n>>>>>>>>>>>>>> APPLYING DELTA STARTED <<<<<<<<<<<<<<✅\n");
+        // Validate the cover, delta and stego file names
+        if (read_and_validate_apply_args(cli.files, cli.cover_fname, &deltaInfo) != e_success) // If validation fails
+        {
+            print_error("\n.............Applying delta failed due to improper filenames..............❌\n");
+            return EXIT_USAGE;
+        }
+        // Rebuild the stego image
+        if (do_delta_apply(&deltaInfo) != e_success)
+            return EXIT_FAILED;
+        print_status("\n>>>>>>>>>>>>>>>>> DELTA IS APPLIED SUCCESSFULLY <<<<<<<<<<<<<<<<<<✅\n");
     }
 
-    return 0; // Exit with success status
-}
\ No newline at end of file
+    return EXIT_OK; // Exit with success status
+}
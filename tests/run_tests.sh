@@ -0,0 +1,43 @@
+#!/bin/sh
+# DOCUMENTATION
+# Discription : Builds the tool and every tests/test_*.c against the sources,
+# then runs each test in a scratch directory.
+# Usage : tests/run_tests.sh   (from anywhere, needs gcc)
+# Every test gets the repository directory (for beautiful.bmp and secret.txt)
+# and the built tool as arguments and exits non zero on a failure.
+set -u
+repo=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+CFLAGS="-O2 -Wall"
+
+# Every source is compiled once, the tests link all of them but the tool's main
+mkdir "$work/obj"
+for src in "$repo"/*.c
+do
+    gcc $CFLAGS -c -o "$work/obj/$(basename "$src" .c).o" "$src" || exit 1
+done
+objects=$(ls "$work"/obj/*.o | grep -v '/test_encode\.o$')
+gcc -o "$work/steg" "$work"/obj/*.o -lm -lpthread || exit 1
+
+failed=0
+for test_src in "$repo"/tests/test_*.c
+do
+    name=$(basename "$test_src" .c)
+    if ! gcc $CFLAGS -I"$repo" -o "$work/$name" "$test_src" $objects -lm -lpthread
+    then
+        echo "$name : BUILD FAILED"
+        failed=1
+        continue
+    fi
+    mkdir "$work/$name.d"
+    if (cd "$work/$name.d" && "$work/$name" "$repo" "$work/steg")
+    then
+        echo "$name : PASSED"
+    else
+        echo "$name : FAILED"
+        failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,196 @@
+/* DOCUMENTATION
+Discription : Known answer tests of the primitives behind "-k".
+SHA-256 (FIPS 180-2 examples), HMAC-SHA256 (RFC 4231), PBKDF2-HMAC-SHA256
+(RFC 7914 section 11) and ChaCha20 (RFC 8439 sections 2.3.2 and 2.4.2),
+plus a round trip through cipher_init_encrypt/cipher_init_decrypt, and a
+decode with a wrong or missing passphrase that must leave the output alone.
+Usage : test_crypto <repo dir> <tool>*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include "sha256.h"
+#include "cipher.h"
+
+static int failures=0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL %s:%d : ",__FILE__,__LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+// Function to decode a hex string into bytes, returns the number of bytes
+static size_t from_hex(const char *hex, unsigned char *out)
+{
+    size_t n=0;
+    for(;hex[0]!='\0' && hex[1]!='\0';hex+=2)
+    {
+        unsigned int byte;
+        sscanf(hex,"%2x",&byte);
+        out[n++]=byte;
+    }
+    return n;
+}
+
+// Function to compare bytes with the expected hex string
+static int matches_hex(const unsigned char *data, size_t size, const char *hex)
+{
+    unsigned char expected[256];
+    return from_hex(hex,expected)==size && memcmp(data,expected,size)==0;
+}
+
+// Function to check SHA-256 of a message, hashed in pieces of step bytes
+static void check_sha256(const char *msg, size_t size, size_t repeat, size_t step, const char *hex)
+{
+    Sha256 ctx;
+    unsigned char digest[SHA256_DIGEST_SIZE];
+    sha256_init(&ctx);
+    for(size_t r=0;r<repeat;r++)
+        for(size_t i=0;i<size;i+=step)
+            sha256_update(&ctx,msg+i,(size-i<step) ? size-i : step);
+    sha256_final(&ctx,digest);
+    CHECK(matches_hex(digest,SHA256_DIGEST_SIZE,hex),"SHA-256 of %zu x '%.20s'",repeat,msg);
+}
+
+static void test_sha256(void)
+{
+    unsigned char digest[SHA256_DIGEST_SIZE];
+    sha256("",0,digest);
+    CHECK(matches_hex(digest,SHA256_DIGEST_SIZE,"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"),"SHA-256 of the empty string");
+    check_sha256("abc",3,1,3,"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    const char *two_blocks="abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    check_sha256(two_blocks,strlen(two_blocks),1,strlen(two_blocks),"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    check_sha256(two_blocks,strlen(two_blocks),1,7,"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    check_sha256("aaaaaaaaaa",10,100000,3,"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+static void test_hmac_sha256(void)
+{
+    unsigned char key[131],digest[SHA256_DIGEST_SIZE];
+
+    memset(key,0x0b,20); // RFC 4231 test case 1
+    hmac_sha256(key,20,"Hi There",8,digest);
+    CHECK(matches_hex(digest,SHA256_DIGEST_SIZE,"b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"),"HMAC-SHA256 test case 1");
+
+    const char *data="what do ya want for nothing?"; // Test case 2
+    hmac_sha256("Jefe",4,data,strlen(data),digest);
+    CHECK(matches_hex(digest,SHA256_DIGEST_SIZE,"5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"),"HMAC-SHA256 test case 2");
+
+    memset(key,0xaa,131); // Test case 6, key longer than a block
+    data="Test Using Larger Than Block-Size Key - Hash Key First";
+    hmac_sha256(key,131,data,strlen(data),digest);
+    CHECK(matches_hex(digest,SHA256_DIGEST_SIZE,"60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"),"HMAC-SHA256 test case 6");
+}
+
+static void test_pbkdf2(void)
+{
+    unsigned char out[64];
+    pbkdf2_hmac_sha256("passwd",6,(const unsigned char *)"salt",4,1,out,64);
+    CHECK(matches_hex(out,64,"55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc"
+                             "49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783"),"PBKDF2 passwd/salt/1");
+    pbkdf2_hmac_sha256("Password",8,(const unsigned char *)"NaCl",4,80000,out,64);
+    CHECK(matches_hex(out,64,"4ddcd8f60b98be21830cee5ef22701f9641a4418d04c0414aeff08876b34ab56"
+                             "a1d425a1225833549adb841b51c9b3176a272bdebba1d078478f62b397f33c8d"),"PBKDF2 Password/NaCl/80000");
+}
+
+static void test_chacha20(void)
+{
+    unsigned char key[32],nonce[CIPHER_NONCE_SIZE];
+    char block[64]={0},text[256];
+    CipherStream cs;
+    for(int i=0;i<32;i++)
+        key[i]=i;
+
+    // Section 2.3.2, the keystream of block 1 is the block function output
+    from_hex("000000090000004a00000000",nonce);
+    cipher_init_key(&cs,key,nonce,1);
+    cipher_xor(&cs,block,sizeof(block));
+    CHECK(matches_hex((unsigned char *)block,sizeof(block),"10f1e7e4d13b5915500fdd1fa32071c4c7d1f4c733c068030422aa9ac3d46c4e"
+                                                           "d2826446079faa0914c2d705d98b02a2b5129cd1de164eb9cbd083e8a2503c4e"),"ChaCha20 block function");
+
+    // Section 2.4.2, encrypted in uneven pieces so the keystream has to carry over
+    const char *plain="Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+    const char *cipher_hex="6e2e359a2568f98041ba0728dd0d6981e97e7aec1d4360c20a27afccfd9fae0bf91b65c5524733ab8f593dabcd62b357"
+                           "1639d624e65152ab8f530c359f0861d807ca0dbf500d6a6156a38e088a22b65e52bc514d16ccf806818ce91ab7793736"
+                           "5af90bbf74a35be6b40b8eedf2785e42874d";
+    size_t len=strlen(plain);
+    memcpy(text,plain,len);
+    from_hex("000000000000004a00000000",nonce);
+    cipher_init_key(&cs,key,nonce,1);
+    cipher_xor(&cs,text,1);
+    cipher_xor(&cs,text+1,62);
+    cipher_xor(&cs,text+63,len-63);
+    CHECK(matches_hex((unsigned char *)text,len,cipher_hex),"ChaCha20 encryption");
+
+    // Past the four blocks generated at once
+    char a[1000],b[1000];
+    for(int i=0;i<1000;i++)
+        a[i]=b[i]=i;
+    cipher_init_key(&cs,key,nonce,1);
+    cipher_xor(&cs,a,1000);
+    cipher_init_key(&cs,key,nonce,1);
+    for(int i=0;i<1000;i+=37)
+        cipher_xor(&cs,b+i,(1000-i<37) ? 1000-i : 37);
+    CHECK(memcmp(a,b,1000)==0,"ChaCha20 keystream depends on the piece sizes");
+    cipher_init_key(&cs,key,nonce,5); // Block 5 is the first byte 256 of a stream starting at block 1
+    memset(block,0,sizeof(block));
+    cipher_xor(&cs,block,sizeof(block));
+    for(int i=0;i<64;i++)
+        block[i]^=(char)(256+i);
+    CHECK(memcmp(block,a+256,64)==0,"ChaCha20 block counter past the first four blocks");
+}
+
+static void test_passphrase(void)
+{
+    unsigned char params[CIPHER_HEADER_SIZE];
+    CipherStream enc,dec;
+    char text[100],orig[100];
+    for(int i=0;i<100;i++)
+        orig[i]=text[i]=i*7;
+
+    CHECK(cipher_init_encrypt(&enc,"secret",params)==e_success,"cipher_init_encrypt failed");
+    cipher_xor(&enc,text,sizeof(text));
+    CHECK(memcmp(text,orig,sizeof(text))!=0,"data not encrypted");
+    CHECK(cipher_init_decrypt(&dec,"wrong",params)==e_failure,"wrong passphrase accepted");
+    CHECK(cipher_init_decrypt(&dec,"secret",params)==e_success,"right passphrase rejected");
+    cipher_xor(&dec,text,sizeof(text));
+    CHECK(memcmp(text,orig,sizeof(text))==0,"round trip does not give the data back");
+}
+
+// Function to run the tool with its output discarded, returns its exit status
+static int run_tool(const char *tool, const char *args)
+{
+    char cmd[8192];
+    snprintf(cmd,sizeof(cmd),"%s -q %s >/dev/null 2>&1",tool,args);
+    int status=system(cmd);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void test_wrong_passphrase(const char *repo, const char *tool)
+{
+    char args[8192],text[16]={0};
+    snprintf(args,sizeof(args),"-e %s/beautiful.bmp %s/secret.txt stego.bmp -k secret",repo,repo);
+    CHECK(run_tool(tool,args)==0,"encoding with -k failed");
+    FILE *fptr=fopen("out.txt","w");
+    fputs("keep",fptr);
+    fclose(fptr);
+    CHECK(run_tool(tool,"-d stego.bmp out -k wrong")==1,"wrong passphrase not reported");
+    CHECK(run_tool(tool,"-d stego.bmp out")==1,"missing passphrase not reported");
+    fptr=fopen("out.txt","r");
+    CHECK(fptr!=NULL && fread(text,1,sizeof(text)-1,fptr)==4 && strcmp(text,"keep")==0,"failed decode changed out.txt");
+    if(fptr!=NULL)
+        fclose(fptr);
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc!=3)
+    {
+        printf("Usage : %s <repo dir> <tool>\n",argv[0]);
+        return 2;
+    }
+    test_sha256();
+    test_hmac_sha256();
+    test_pbkdf2();
+    test_chacha20();
+    test_passphrase();
+    test_wrong_passphrase(argv[1],argv[2]);
+    return failures==0 ? 0 : 1;
+}
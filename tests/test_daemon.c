@@ -0,0 +1,248 @@
+/* DOCUMENTATION
+Discription : Tests of the daemon mode.
+Starts "-s" with a single worker and talks to it over the Unix socket :
+requests by path and with passed descriptors (SCM_RIGHTS), a probe of an
+image too small for the stego header, pipes instead of files, an output name
+in a dotted directory, an unknown request, and a client that stays connected
+without sending anything while others are served.
+Usage : test_daemon <repo dir> <tool>*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#define SOCKET_FNAME "steg.sock"
+#define REPLY_TIMEOUT_MS 5000
+
+static int failures=0;
+static pid_t pipe_children[8];
+static int num_pipe_children=0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL %s:%d : ",__FILE__,__LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+// Function to connect to the daemon, retrying while it starts
+static int connect_daemon(void)
+{
+    struct sockaddr_un addr={0};
+    addr.sun_family=AF_UNIX;
+    strcpy(addr.sun_path,SOCKET_FNAME);
+    for(int i=0;i<100;i++)
+    {
+        int fd=socket(AF_UNIX,SOCK_SEQPACKET,0);
+        if(fd>=0 && connect(fd,(struct sockaddr *)&addr,sizeof(addr))==0)
+            return fd;
+        if(fd>=0)
+            close(fd);
+        usleep(50000);
+    }
+    return -1;
+}
+
+// Function to send one request with its descriptors and wait for the reply, "" on a timeout
+static void request(int conn_fd, const char *msg, int *fds, int num_fds, char *reply, int reply_size)
+{
+    char control[CMSG_SPACE(sizeof(int)*3)]={0};
+    struct iovec iov={(char *)msg,strlen(msg)};
+    struct msghdr hdr={0};
+    hdr.msg_iov=&iov;
+    hdr.msg_iovlen=1;
+    if(num_fds>0)
+    {
+        hdr.msg_control=control;
+        hdr.msg_controllen=CMSG_SPACE(sizeof(int)*num_fds);
+        struct cmsghdr *cmsg=CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level=SOL_SOCKET;
+        cmsg->cmsg_type=SCM_RIGHTS;
+        cmsg->cmsg_len=CMSG_LEN(sizeof(int)*num_fds);
+        memcpy(CMSG_DATA(cmsg),fds,sizeof(int)*num_fds);
+    }
+    reply[0]='\0';
+    if(sendmsg(conn_fd,&hdr,MSG_NOSIGNAL)<0)
+        return;
+    struct pollfd pfd={conn_fd,POLLIN,0};
+    if(poll(&pfd,1,REPLY_TIMEOUT_MS)!=1)
+        return;
+    ssize_t n=recv(conn_fd,reply,reply_size-1,0);
+    reply[n>0 ? n : 0]='\0';
+}
+
+// Function to compare two files byte for byte
+static int same_file(const char *a, const char *b)
+{
+    FILE *fa=fopen(a,"rb"),*fb=fopen(b,"rb");
+    int same=(fa!=NULL && fb!=NULL);
+    while(same)
+    {
+        int ca=fgetc(fa),cb=fgetc(fb);
+        if(ca!=cb)
+            same=0;
+        if(ca==EOF || cb==EOF)
+            break;
+    }
+    if(fa!=NULL)
+        fclose(fa);
+    if(fb!=NULL)
+        fclose(fb);
+    return same;
+}
+
+// Function to copy between two descriptors until the end of the input
+static void copy_fd(int in_fd, int out_fd)
+{
+    char buf[65536];
+    ssize_t n;
+    while((n=read(in_fd,buf,sizeof(buf)))>0)
+        if(write(out_fd,buf,n)!=n)
+            break;
+}
+
+// Function to get a pipe fed with a file by a child process, write_end picks which end the caller keeps
+static int pipe_file(const char *fname, int write_end)
+{
+    int p[2];
+    if(pipe(p)!=0)
+        return -1;
+    pid_t pid=fork();
+    if(pid==0)
+    {
+        int fd=write_end ? open(fname,O_WRONLY|O_CREAT|O_TRUNC,0644) : open(fname,O_RDONLY);
+        close(write_end ? p[1] : p[0]);
+        if(write_end)
+            copy_fd(p[0],fd);
+        else
+            copy_fd(fd,p[1]);
+        _exit(0);
+    }
+    pipe_children[num_pipe_children++]=pid;
+    close(write_end ? p[0] : p[1]);
+    return write_end ? p[1] : p[0];
+}
+
+// Function to wait until the pipe children are done with their files
+static void wait_pipe_children(void)
+{
+    while(num_pipe_children>0)
+        waitpid(pipe_children[--num_pipe_children],NULL,0);
+}
+
+// Function to write a BMP of 4x4 pixels, too small to hold the stego header
+static void write_tiny_bmp(const char *cover, const char *fname)
+{
+    char image[256]={0};
+    FILE *in=fopen(cover,"rb");
+    if(in==NULL || fread(image,1,54,in)!=54)
+        CHECK(0,"cannot read %s",cover);
+    if(in!=NULL)
+        fclose(in);
+    int side=4;
+    memcpy(image+18,&side,sizeof(int));
+    memcpy(image+22,&side,sizeof(int));
+    FILE *out=fopen(fname,"wb");
+    fwrite(image,1,sizeof(image),out);
+    fclose(out);
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc!=3)
+    {
+        printf("Usage : %s <repo dir> <tool>\n",argv[0]);
+        return 2;
+    }
+    char cover[4096],secret[4096],reference[4096],msg[16384],reply[4096];
+    snprintf(cover,sizeof(cover),"%s/beautiful.bmp",argv[1]);
+    snprintf(secret,sizeof(secret),"%s/secret.txt",argv[1]);
+    snprintf(reference,sizeof(reference),"%s/output.bmp",argv[1]);
+
+    pid_t pid=fork();
+    if(pid==0)
+    {
+        execl(argv[2],argv[2],"-q","-s",SOCKET_FNAME,"1",(char *)NULL);
+        _exit(127);
+    }
+
+    // One worker only, an idle client must not keep it from the others
+    int idle_fd=connect_daemon();
+    int conn_fd=connect_daemon();
+    CHECK(idle_fd>=0 && conn_fd>=0,"cannot connect to the daemon");
+
+    snprintf(msg,sizeof(msg),"PROBE %s",cover);
+    request(conn_fd,msg,NULL,0,reply,sizeof(reply));
+    CHECK(strncmp(reply,"OK op=probe stego=0 capacity=",29)==0,"probe of the cover : '%s'",reply);
+
+    snprintf(msg,sizeof(msg),"ENCODE %s %s stego.bmp",cover,secret);
+    request(conn_fd,msg,NULL,0,reply,sizeof(reply));
+    CHECK(strncmp(reply,"OK op=encode size=25 extn=.txt",30)==0,"encode by path : '%s'",reply);
+    CHECK(same_file("stego.bmp",reference),"stego.bmp differs from output.bmp");
+
+    // Both files as passed descriptors, the secret is written through the second one
+    int fds[2]={open("stego.bmp",O_RDONLY),open("decoded",O_WRONLY|O_CREAT|O_TRUNC,0644)};
+    request(conn_fd,"DECODE - -",fds,2,reply,sizeof(reply));
+    close(fds[0]);
+    close(fds[1]);
+    CHECK(strncmp(reply,"OK op=decode size=25 extn=.txt",30)==0 && strstr(reply,"out=-")!=NULL,"decode with descriptors : '%s'",reply);
+    CHECK(same_file("decoded",secret),"secret decoded through a descriptor differs");
+
+    request(conn_fd,"DECODE stego.bmp named.bin",NULL,0,reply,sizeof(reply));
+    CHECK(strncmp(reply,"OK op=decode",12)==0 && strstr(reply,"out=named.txt")!=NULL,"decode by path : '%s'",reply);
+    CHECK(same_file("named.txt",secret),"secret decoded by path differs");
+
+    // Pipes in and out, the inputs are read to their end before the request runs
+    int pipe_fds[3]={pipe_file(cover,0),pipe_file(secret,0),pipe_file("piped.bmp",1)};
+    request(conn_fd,"ENCODE - - - .txt",pipe_fds,3,reply,sizeof(reply));
+    for(int i=0;i<3;i++)
+        close(pipe_fds[i]);
+    wait_pipe_children();
+    CHECK(strncmp(reply,"OK op=encode size=25 extn=.txt",30)==0,"encode through pipes : '%s'",reply);
+    CHECK(same_file("piped.bmp",reference),"stego image written to a pipe differs from output.bmp");
+    pipe_fds[0]=pipe_file("stego.bmp",0);
+    pipe_fds[1]=pipe_file("piped",1);
+    request(conn_fd,"DECODE - -",pipe_fds,2,reply,sizeof(reply));
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    wait_pipe_children();
+    CHECK(strncmp(reply,"OK op=decode size=25",20)==0,"decode through pipes : '%s'",reply);
+    CHECK(same_file("piped",secret),"secret written to a pipe differs");
+
+    // Only the base name has an extension to replace
+    mkdir("sub.d",0755);
+    request(conn_fd,"DECODE stego.bmp sub.d/out",NULL,0,reply,sizeof(reply));
+    CHECK(strstr(reply,"out=sub.d/out.txt")!=NULL,"decode into a dotted directory : '%s'",reply);
+    CHECK(same_file("sub.d/out.txt",secret),"secret decoded into sub.d differs");
+
+    fds[0]=open("stego.bmp",O_RDONLY);
+    request(conn_fd,"PROBE -",fds,1,reply,sizeof(reply));
+    close(fds[0]);
+    CHECK(strncmp(reply,"OK op=probe stego=1 extn=.txt size=25",37)==0,"probe of the stego image : '%s'",reply);
+
+    write_tiny_bmp(cover,"tiny.bmp");
+    request(conn_fd,"PROBE tiny.bmp",NULL,0,reply,sizeof(reply));
+    CHECK(strcmp(reply,"OK op=probe stego=0 capacity=0")==0,"probe of a tiny image : '%s'",reply);
+
+    request(conn_fd,"PROBE missing.bmp",NULL,0,reply,sizeof(reply));
+    CHECK(strncmp(reply,"ERR ",4)==0,"probe of a missing file : '%s'",reply);
+    request(conn_fd,"HELLO",NULL,0,reply,sizeof(reply));
+    CHECK(strcmp(reply,"ERR unsupported request")==0,"unknown request : '%s'",reply);
+
+    // The idle client is still served once it sends something
+    request(idle_fd,"PROBE tiny.bmp",NULL,0,reply,sizeof(reply));
+    CHECK(strcmp(reply,"OK op=probe stego=0 capacity=0")==0,"request of the idle client : '%s'",reply);
+
+    close(idle_fd);
+    close(conn_fd);
+    kill(pid,SIGTERM);
+    int status=0;
+    waitpid(pid,&status,0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status)==0,"daemon exit status %d",status);
+    struct stat st;
+    CHECK(stat(SOCKET_FNAME,&st)!=0,"socket file left behind");
+
+    return failures==0 ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/* DOCUMENTATION
+Discription : Tests of the delta output.
+Round trips "-e -P" and "-e -L" through "-d" and "-a", the rebuilt stego
+image must be byte for byte what "-e" writes. A cover that is not the one
+of the delta, a delta with a damaged byte and a delta with a crafted range
+must be refused, and the decoded name keeps a dotted directory.
+Usage : test_delta <repo dir> <tool>*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+static int failures=0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL %s:%d : ",__FILE__,__LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+// Function to read a whole file, NULL on error
+static char *read_file(const char *fname, long *size)
+{
+    FILE *fptr=fopen(fname,"rb");
+    if(fptr==NULL)
+        return NULL;
+    fseek(fptr,0,SEEK_END);
+    *size=ftell(fptr);
+    rewind(fptr);
+    char *data=malloc(*size);
+    if(data!=NULL && fread(data,1,*size,fptr)!=(size_t)*size)
+    {
+        free(data);
+        data=NULL;
+    }
+    fclose(fptr);
+    return data;
+}
+
+// Function to write a whole file
+static void write_file(const char *fname, const char *data, long size)
+{
+    FILE *fptr=fopen(fname,"wb");
+    fwrite(data,1,size,fptr);
+    fclose(fptr);
+}
+
+// Function to run the tool with its output discarded, returns its exit status
+static int run_tool(const char *tool, const char *args)
+{
+    char cmd[16384];
+    snprintf(cmd,sizeof(cmd),"%s -q %s >/dev/null 2>&1",tool,args);
+    int status=system(cmd);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Function to compare two files byte for byte
+static int same_file(const char *a, const char *b)
+{
+    long size_a=0,size_b=0;
+    char *data_a=read_file(a,&size_a),*data_b=read_file(b,&size_b);
+    int same=(data_a!=NULL && data_b!=NULL && size_a==size_b && memcmp(data_a,data_b,size_a)==0);
+    free(data_a);
+    free(data_b);
+    return same;
+}
+
+// Function to write a copy of a file with one byte flipped, offset from the end when negative
+static void write_damaged(const char *fname, const char *out, long offset)
+{
+    long size=0;
+    char *data=read_file(fname,&size);
+    if(data==NULL)
+        return;
+    data[(offset<0) ? size+offset : offset]^=0x55;
+    write_file(out,data,size);
+    free(data);
+}
+
+// Function to round trip a delta written with the given option
+static void check_round_trip(const char *repo, const char *tool, const char *option)
+{
+    char args[8192];
+    remove("out.txt");
+    remove("rebuilt.bmp");
+    snprintf(args,sizeof(args),"-e %s %s/beautiful.bmp secret.txt stego.delta",option,repo);
+    CHECK(run_tool(tool,args)==0,"encoding with %s failed",option);
+    CHECK(run_tool(tool,"-d stego.delta out")==0 && same_file("out.txt","secret.txt"),"decoding the %s delta failed",option);
+    snprintf(args,sizeof(args),"-d stego.delta out -c %s/beautiful.bmp",repo);
+    CHECK(run_tool(tool,args)==0,"decoding the %s delta checked against its cover failed",option);
+    snprintf(args,sizeof(args),"-a -c %s/beautiful.bmp stego.delta rebuilt.bmp",repo);
+    CHECK(run_tool(tool,args)==0 && same_file("rebuilt.bmp","stego.bmp"),"%s delta does not rebuild the -e image",option);
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc!=3)
+    {
+        printf("Usage : %s <repo dir> <tool>\n",argv[0]);
+        return 2;
+    }
+    const char *tool=argv[2];
+    char args[8192],cover[4096],secret_fname[4096];
+    snprintf(cover,sizeof(cover),"%s/beautiful.bmp",argv[1]);
+    snprintf(secret_fname,sizeof(secret_fname),"%s/secret.txt",argv[1]);
+
+    long size=0;
+    char *secret=read_file(secret_fname,&size); // Copied here to compare the decoded files with
+    CHECK(secret!=NULL,"cannot read secret.txt");
+    if(secret==NULL)
+        return 1;
+    write_file("secret.txt",secret,size);
+    free(secret);
+    snprintf(args,sizeof(args),"-e %s secret.txt stego.bmp",cover);
+    CHECK(run_tool(tool,args)==0,"encoding failed");
+    check_round_trip(argv[1],tool,"-P");
+    check_round_trip(argv[1],tool,"-L");
+
+    // The decoded name only replaces the extension of the base name
+    mkdir("sub.d",0755);
+    CHECK(run_tool(tool,"-d stego.delta sub.d/out")==0 && same_file("sub.d/out.txt","secret.txt"),"decoding into sub.d/out did not write sub.d/out.txt");
+
+    // Another cover, the last pixel byte is outside the modified range
+    write_damaged(cover,"other.bmp",-1);
+    CHECK(run_tool(tool,"-a -c other.bmp stego.delta rebuilt.bmp")==1,"delta applied to another cover");
+    CHECK(run_tool(tool,"-d stego.delta out -c other.bmp")==1,"delta decoded against another cover");
+
+    // A damaged modified byte no longer matches the stego hash
+    write_damaged("stego.delta","damaged.delta",-1);
+    snprintf(args,sizeof(args),"-a -c %s damaged.delta rebuilt.bmp",cover);
+    CHECK(run_tool(tool,args)==1,"damaged delta applied");
+
+    // A crafted offset near 2^63 must not overflow the range checks
+    long delta_size=0;
+    char *delta=read_file("stego.delta",&delta_size);
+    if(delta!=NULL)
+    {
+        unsigned long long offset=(1ULL<<63)-100;
+        for(int i=0;i<8;i++)
+            delta[16+i]=offset>>(8*i);
+        write_file("crafted.delta",delta,delta_size);
+        free(delta);
+    }
+    snprintf(args,sizeof(args),"-a -c %s crafted.delta rebuilt.bmp",cover);
+    CHECK(run_tool(tool,args)==1,"delta with a crafted offset applied");
+    snprintf(args,sizeof(args),"-d crafted.delta out -c %s",cover);
+    CHECK(run_tool(tool,args)==1,"delta with a crafted offset decoded");
+    return failures==0 ? 0 : 1;
+}
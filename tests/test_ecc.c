@@ -0,0 +1,175 @@
+/* DOCUMENTATION
+Discription : Tests of the Reed-Solomon protection of the secret.
+Encodes with "-r 32" (16 correctable bytes per codeword), flips image LSBs
+spread over every codeword and checks that "-d" gives the secret back byte
+for byte, then flips one byte more than a codeword can correct and checks
+that decoding fails. With "-k" the salt, nonce and key check are in the
+codewords too, so damage there is corrected like any other. The size and
+flags of the stego header are not in the codewords, flipping them must be
+made up for by the header copies.
+Usage : test_ecc <repo dir> <tool>*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include "common.h"
+#include "ecc.h"
+#include "cipher.h"
+
+#define PARITY 32
+#define SECRET_SIZE 3000
+
+static int failures=0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL %s:%d : ",__FILE__,__LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+// Function to read a whole file, NULL on error
+static char *read_file(const char *fname, long *size)
+{
+    FILE *fptr=fopen(fname,"rb");
+    if(fptr==NULL)
+        return NULL;
+    fseek(fptr,0,SEEK_END);
+    *size=ftell(fptr);
+    rewind(fptr);
+    char *data=malloc(*size);
+    if(data!=NULL && fread(data,1,*size,fptr)!=(size_t)*size)
+    {
+        free(data);
+        data=NULL;
+    }
+    fclose(fptr);
+    return data;
+}
+
+// Function to write a whole file
+static void write_file(const char *fname, const char *data, long size)
+{
+    FILE *fptr=fopen(fname,"wb");
+    fwrite(data,1,size,fptr);
+    fclose(fptr);
+}
+
+// Function to run the tool with its output discarded, returns its exit status
+static int run_tool(const char *tool, const char *args)
+{
+    char cmd[8192];
+    snprintf(cmd,sizeof(cmd),"%s -q %s >/dev/null 2>&1",tool,args);
+    int status=system(cmd);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Function to flip bits of the LSB carriers of payload byte row*blocks+block, mask picks the carriers
+static void damage_byte(char *image, long blocks, int row, long block, int mask)
+{
+    long carrier=BMP_HEADER_SIZE+STEGO_HEADER_SIZE+STEGO_HEADER_COPIES_SPAN+8*(row*blocks+block); // Codewords follow the header copies
+    for(int bit=0;bit<8;bit++)
+        if(mask&(1<<bit))
+            image[carrier+bit]^=1;
+}
+
+// Function to flip the LSB carrying bit of a 32 bit header field, field is its first image byte
+static void flip_field_bit(char *image, long field, int bit)
+{
+    image[field+31-bit]^=1;
+}
+
+// Function to decode damaged.bmp and compare the result with the secret, returns the exit status of -d
+static int decode_and_compare(const char *tool, const char *secret, int *same)
+{
+    remove("decoded.txt");
+    int status=run_tool(tool,"-d damaged.bmp decoded");
+    long size=0;
+    char *decoded=read_file("decoded.txt",&size);
+    *same=(decoded!=NULL && size==SECRET_SIZE && memcmp(decoded,secret,SECRET_SIZE)==0);
+    free(decoded);
+    return status;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc!=3)
+    {
+        printf("Usage : %s <repo dir> <tool>\n",argv[0]);
+        return 2;
+    }
+    const char *tool=argv[2];
+    char args[8192],secret[SECRET_SIZE];
+    long size;
+    int same;
+
+    srand(29);
+    for(int i=0;i<SECRET_SIZE;i++)
+        secret[i]=rand();
+    write_file("secret.txt",secret,SECRET_SIZE);
+    snprintf(args,sizeof(args),"-e %s/beautiful.bmp secret.txt stego.bmp -r %d",argv[1],PARITY);
+    CHECK(run_tool(tool,args)==0,"encoding with -r %d failed",PARITY);
+
+    char *stego=read_file("stego.bmp",&size);
+    CHECK(stego!=NULL,"cannot read stego.bmp");
+    if(stego==NULL)
+        return 1;
+    char *image=malloc(size);
+    long blocks=rs_encoded_size(PARITY,SECRET_SIZE)/RS_BLOCK_SIZE;
+
+    // The limit in every codeword, some bytes with all 8 LSBs flipped, parity rows included
+    memcpy(image,stego,size);
+    for(long b=0;b<blocks;b++)
+        for(int i=0;i<PARITY/2;i++)
+            damage_byte(image,blocks,(b*7+i*13)%RS_BLOCK_SIZE,b,(i%4==0) ? 0xff : 1<<(i%8));
+    write_file("damaged.bmp",image,size);
+    CHECK(decode_and_compare(tool,secret,&same)==0 && same,"%d damaged bytes per codeword not corrected",PARITY/2);
+
+    // Header fields outside the codewords, one copy or all three damaged in different bits
+    long extn_field=BMP_HEADER_SIZE+32+8*(sizeof(MAGIC_STRING)-1);
+    long size_field=BMP_HEADER_SIZE+STEGO_HEADER_SIZE-32;
+    long copy=BMP_HEADER_SIZE+STEGO_HEADER_SIZE; // First header copy, the size is its bytes 8..11
+    memcpy(image,stego,size);
+    flip_field_bit(image,size_field,25);
+    flip_field_bit(image,extn_field,16); // ECC flag
+    flip_field_bit(image,extn_field,30); // Parity
+    write_file("damaged.bmp",image,size);
+    CHECK(decode_and_compare(tool,secret,&same)==0 && same,"damaged size and flags not recovered from the header copies");
+    memcpy(image,stego,size);
+    flip_field_bit(image,size_field,3);
+    flip_field_bit(image,copy+8*8,7);
+    flip_field_bit(image,copy+8*(STEGO_HEADER_COPY_SIZE+8),12);
+    write_file("damaged.bmp",image,size);
+    CHECK(decode_and_compare(tool,secret,&same)==0 && same,"size damaged in the header and both copies not recovered");
+
+    // A run of damaged image bytes is spread over the codewords by the interleaving
+    memcpy(image,stego,size);
+    for(long k=0;k<blocks*(PARITY/2);k++)
+        damage_byte(image,1,0,k,1);
+    write_file("damaged.bmp",image,size);
+    CHECK(decode_and_compare(tool,secret,&same)==0 && same,"burst of %ld damaged bytes not corrected",blocks*(PARITY/2));
+
+    // One byte past the limit in a single codeword
+    memcpy(image,stego,size);
+    for(int i=0;i<PARITY/2+1;i++)
+        damage_byte(image,blocks,(3+i*13)%RS_BLOCK_SIZE,blocks/2,1);
+    write_file("damaged.bmp",image,size);
+    CHECK(decode_and_compare(tool,secret,&same)==1 && !same,"%d damaged bytes in a codeword were not reported",PARITY/2+1);
+
+    // Encrypted, the cipher parameters are the first bytes of the first codewords
+    snprintf(args,sizeof(args),"-e %s/beautiful.bmp secret.txt damaged.bmp -r %d -k passphrase",argv[1],PARITY);
+    CHECK(run_tool(tool,args)==0,"encoding with -r %d -k failed",PARITY);
+    free(image);
+    image=read_file("damaged.bmp",&size);
+    if(image==NULL)
+        return 1;
+    blocks=rs_encoded_size(PARITY,CIPHER_HEADER_SIZE+SECRET_SIZE)/RS_BLOCK_SIZE;
+    for(int i=0;i<PARITY/2;i++) // Rows 0..15 of the codeword holding the cipher parameters
+        damage_byte(image,blocks,i,0,0xff);
+    write_file("damaged.bmp",image,size);
+    remove("decoded.txt");
+    CHECK(run_tool(tool,"-d damaged.bmp decoded -k passphrase")==0,"damaged cipher parameters not corrected");
+    long decoded_size=0;
+    char *decoded=read_file("decoded.txt",&decoded_size);
+    CHECK(decoded!=NULL && decoded_size==SECRET_SIZE && memcmp(decoded,secret,SECRET_SIZE)==0,"encrypted secret differs");
+    free(decoded);
+
+    free(image);
+    free(stego);
+    return failures==0 ? 0 : 1;
+}
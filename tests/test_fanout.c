@@ -0,0 +1,109 @@
+/* DOCUMENTATION
+Discription : Tests of the fan-out mode.
+Encodes several secrets into one cover with "-f" and checks that every
+output is byte for byte what "-e" writes for the same secret, with and
+without ECC. Secrets that are not .txt or .c and secrets that would give
+the same output name are refused, and "-S" still prints with "-q".
+Usage : test_fanout <repo dir> <tool>*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+static int failures=0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL %s:%d : ",__FILE__,__LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+static const char *secrets[]={"a.txt","b.c","c.txt"};
+#define NUM_SECRETS 3
+
+// Function to write a string as a whole file
+static void write_file(const char *fname, const char *text)
+{
+    FILE *fptr=fopen(fname,"wb");
+    fputs(text,fptr);
+    fclose(fptr);
+}
+
+// Function to run the tool with its output discarded, returns its exit status
+static int run_tool(const char *tool, const char *args)
+{
+    char cmd[16384];
+    snprintf(cmd,sizeof(cmd),"%s -q %s >/dev/null 2>&1",tool,args);
+    int status=system(cmd);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Function to compare two files byte for byte
+static int same_file(const char *a, const char *b)
+{
+    FILE *fa=fopen(a,"rb"),*fb=fopen(b,"rb");
+    int same=(fa!=NULL && fb!=NULL);
+    while(same)
+    {
+        int ca=fgetc(fa),cb=fgetc(fb);
+        if(ca!=cb)
+            same=0;
+        if(ca==EOF || cb==EOF)
+            break;
+    }
+    if(fa!=NULL)
+        fclose(fa);
+    if(fb!=NULL)
+        fclose(fb);
+    return same;
+}
+
+// Function to fan out all secrets into dir and compare each output with -e, options are given to both
+static void check_same_as_encode(const char *repo, const char *tool, const char *dir, const char *options)
+{
+    char args[8192],out[4096],ref[4096];
+    mkdir(dir,0755);
+    snprintf(args,sizeof(args),"-f %s/beautiful.bmp %s %s %s -o %s -j 2 %s",repo,secrets[0],secrets[1],secrets[2],dir,options);
+    CHECK(run_tool(tool,args)==0,"fan-out %s failed",options);
+    for(int i=0;i<NUM_SECRETS;i++)
+    {
+        snprintf(ref,sizeof(ref),"ref%d.bmp",i);
+        snprintf(args,sizeof(args),"-e %s/beautiful.bmp %s %s %s",repo,secrets[i],ref,options);
+        CHECK(run_tool(tool,args)==0,"encoding %s %s failed",secrets[i],options);
+        snprintf(out,sizeof(out),"%s/%.1s.bmp",dir,secrets[i]);
+        CHECK(same_file(out,ref),"%s differs from -e %s %s",out,secrets[i],options);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc!=3)
+    {
+        printf("Usage : %s <repo dir> <tool>\n",argv[0]);
+        return 2;
+    }
+    const char *tool=argv[2];
+    char args[8192],line[4096];
+
+    write_file("a.txt","first secret\n");
+    write_file("b.c","int main(void) { return 0; }\n");
+    write_file("c.txt","a third secret, a little longer than the others\n");
+    check_same_as_encode(argv[1],tool,"plain","");
+    check_same_as_encode(argv[1],tool,"ecc","-r 16");
+
+    // Refused secrets
+    write_file("x.jpg","not a text\n");
+    snprintf(args,sizeof(args),"-f %s/beautiful.bmp a.txt x.jpg",argv[1]);
+    CHECK(run_tool(tool,args)==2,"x.jpg accepted as a secret");
+    mkdir("sub",0755);
+    write_file("sub/a.txt","same name\n");
+    snprintf(args,sizeof(args),"-f %s/beautiful.bmp a.txt sub/a.txt -o plain",argv[1]);
+    CHECK(run_tool(tool,args)==2,"two secrets giving plain/a.bmp accepted");
+
+    // Statistics are printed with -q
+    snprintf(args,sizeof(args),"%s -q -S -f %s/beautiful.bmp a.txt -o plain 2>/dev/null",tool,argv[1]);
+    FILE *pipe=popen(args,"r");
+    int found=0;
+    while(pipe!=NULL && fgets(line,sizeof(line),pipe)!=NULL)
+        if(strstr(line,"PSNR")!=NULL)
+            found=1;
+    CHECK(pipe!=NULL && pclose(pipe)==0 && found,"-q -S printed no statistics");
+    return failures==0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/* DOCUMENTATION
+Discription : Tests of the in place update mode.
+Replaces the secret of a stego image with one of the same size, patches a
+few bytes at an offset, replaces it with a shorter secret and with a secret
+of another extension, decoding after each step. After the shorter secret the
+carriers of the old tail must no longer hold the old bytes.
+Usage : test_update <repo dir> <tool>*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include "common.h"
+#include "decode.h"
+
+static int failures=0;
+
+#define CHECK(cond, ...) do { if(!(cond)) { printf("FAIL %s:%d : ",__FILE__,__LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } } while(0)
+
+// Function to read a whole file, NULL on error
+static char *read_file(const char *fname, long *size)
+{
+    FILE *fptr=fopen(fname,"rb");
+    if(fptr==NULL)
+        return NULL;
+    fseek(fptr,0,SEEK_END);
+    *size=ftell(fptr);
+    rewind(fptr);
+    char *data=malloc(*size+1);
+    if(data!=NULL && fread(data,1,*size,fptr)!=(size_t)*size)
+    {
+        free(data);
+        data=NULL;
+    }
+    if(data!=NULL)
+        data[*size]='\0';
+    fclose(fptr);
+    return data;
+}
+
+// Function to write a string as a whole file
+static void write_file(const char *fname, const char *text)
+{
+    FILE *fptr=fopen(fname,"wb");
+    fputs(text,fptr);
+    fclose(fptr);
+}
+
+// Function to run the tool with its output discarded, returns its exit status
+static int run_tool(const char *tool, const char *args)
+{
+    char cmd[8192];
+    snprintf(cmd,sizeof(cmd),"%s -q %s >/dev/null 2>&1",tool,args);
+    int status=system(cmd);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Function to decode stego.bmp and compare the secret with the expected text
+static int decodes_to(const char *tool, const char *fname, const char *text)
+{
+    remove(fname);
+    if(run_tool(tool,"-d stego.bmp out")!=0)
+        return 0;
+    long size=0;
+    char *decoded=read_file(fname,&size);
+    int same=(decoded!=NULL && size==(long)strlen(text) && memcmp(decoded,text,size)==0);
+    free(decoded);
+    return same;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc!=3)
+    {
+        printf("Usage : %s <repo dir> <tool>\n",argv[0]);
+        return 2;
+    }
+    const char *tool=argv[2];
+    char args[8192];
+
+    write_file("token.txt","token-AAAB-1234\n");
+    snprintf(args,sizeof(args),"-e %s/beautiful.bmp token.txt stego.bmp",argv[1]);
+    CHECK(run_tool(tool,args)==0,"encoding failed");
+
+    // Full replace with a secret of the same size
+    write_file("token.txt","token-CCCD-5678\n");
+    CHECK(run_tool(tool,"-u stego.bmp token.txt")==0,"full replace failed");
+    CHECK(decodes_to(tool,"out.txt","token-CCCD-5678\n"),"full replace not decoded");
+
+    // Patch at an offset
+    write_file("patch.bin","ZZ");
+    CHECK(run_tool(tool,"-u stego.bmp patch.bin 6")==0,"patch failed");
+    CHECK(decodes_to(tool,"out.txt","token-ZZCD-5678\n"),"patch not decoded");
+    CHECK(run_tool(tool,"-u stego.bmp patch.bin 17")!=0,"patch past the end of the secret accepted");
+
+    // Shorter secret, the old tail must be gone from the carriers
+    write_file("token.txt","short\n");
+    CHECK(run_tool(tool,"-u stego.bmp token.txt")==0,"shorter replace failed");
+    CHECK(decodes_to(tool,"out.txt","short\n"),"shorter replace not decoded");
+    long size=0;
+    char *image=read_file("stego.bmp",&size);
+    CHECK(image!=NULL,"cannot read stego.bmp");
+    if(image!=NULL)
+    {
+        char tail[10];
+        for(int i=0;i<10;i++)
+            tail[i]=decode_byte_from_lsb(image+BMP_HEADER_SIZE+STEGO_HEADER_SIZE+8*(6+i));
+        CHECK(memcmp(tail,"ZZCD-5678\n",10)!=0,"old secret still in the carriers after the new end");
+        free(image);
+    }
+
+    // Another extension is written to the header
+    write_file("token.c","int token;\n");
+    CHECK(run_tool(tool,"-u stego.bmp token.c")==0,"replace with a .c secret failed");
+    CHECK(decodes_to(tool,"out.c","int token;\n"),".c secret not decoded with its extension");
+    return failures==0 ? 0 : 1;
+}
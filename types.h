@@ -15,6 +15,10 @@ typedef enum
 {
     e_encode,
     e_decode,
+    e_daemon,
+    e_update,
+    e_fanout,
+    e_apply,
     e_unsupported
 } OperationType;
 
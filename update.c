@@ -0,0 +1,254 @@
+/* DOCUMENTATION
+Discription : Updates the hidden secret of an existing stego image in place.
+The current stego header is decoded, the new secret (or a patch at a byte
+offset of the old secret) is compared with the old one, and only the
+carrier bytes of secret bytes that changed are written back with pwrite.
+The secret file size is rewritten when it changes, and so is the extension
+when a new secret has another one.*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/random.h>
+#include "update.h"
+#include "encode.h"
+#include "decode.h"
+#include "fileio.h"
+#include "types.h"
+#include "common.h"
+
+// Function to read and validate update arguments (stego, secret, optional offset)
+Status read_and_validate_update_args(char *files[], UpdateInfo *updInfo)
+{
+    // Check if the stego image file has a .bmp extension
+    if(!has_fname_extn(files[0],".bmp"))
+    {
+        print_error("\n.................STEGO FILE NAME NOT GIVEN..............❓\n");
+        return e_failure;
+    }
+    updInfo->stego_image_fname=files[0];
+
+    if(files[1]==NULL) // New secret or patch file is mandatory
+    {
+        print_error("\n.................SECRET FILE NAME NOT GIVEN..............❓\n");
+        return e_failure;
+    }
+    updInfo->secret_fname=files[1];
+
+    updInfo->patch_offset=-1;
+    if(files[2]!=NULL) // Optional offset, the secret file is then a patch
+    {
+        char *end;
+        updInfo->patch_offset=strtol(files[2],&end,0);
+        if(*end!='\0' || updInfo->patch_offset<0)
+        {
+            print_error("\n.................Invalid patch offset..............❌\n");
+            return e_failure;
+        }
+    }
+    else // A new secret is a .txt or .c file like an encoded one, a patch may be anything
+    {
+        if(!has_fname_extn(files[1],".txt") && !has_fname_extn(files[1],".c"))
+        {
+            print_error(">>>>>>>>>>>>>>>>Invalid Extension................❌\n");
+            return e_failure;
+        }
+    }
+    print_status("\n.......READING AND VALIDATION FILES ARE SUCCESSFULL........✅\n");
+    return e_success;
+}
+
+// Function to open the stego image read-write and decode its current header
+Status open_stego_for_update(UpdateInfo *updInfo)
+{
+    char header[STEGO_HEADER_BUFFER_SIZE]={0};
+
+    updInfo->fd_stego_image=open(updInfo->stego_image_fname,O_RDWR);
+    if(updInfo->fd_stego_image<0)
+    {
+        perror("open");
+        fprintf(stderr, "ERROR: Unable to open file ❌ %s\n", updInfo->stego_image_fname);
+        return e_failure;
+    }
+    updInfo->image_size=get_fd_size(updInfo->fd_stego_image);
+    if(updInfo->image_size<BMP_HEADER_SIZE+(long)STEGO_HEADER_SIZE ||
+       read_full_at(updInfo->fd_stego_image,header,(updInfo->image_size<(long)sizeof(header)) ? updInfo->image_size : (long)sizeof(header),0)!=e_success)
+        return e_failure;
+    updInfo->image_capacity=get_image_size_for_bmp_buffer(header);
+    return decode_header_from_buffer(header,&updInfo->header);
+}
+
+// Function to read the new secret or patch
+Status read_update_secret(UpdateInfo *updInfo)
+{
+    FILE *fptr=fopen(updInfo->secret_fname,"r");
+    if(fptr==NULL)
+    {
+        perror("fopen");
+        fprintf(stderr, "ERROR: Unable to open file ❌ %s\n", updInfo->secret_fname);
+        return e_failure;
+    }
+    updInfo->size_secret=get_file_size(fptr);
+    rewind(fptr);
+    updInfo->secret_data=malloc(updInfo->size_secret+1);
+    if(updInfo->size_secret==0 || updInfo->secret_data==NULL || fread(updInfo->secret_data,updInfo->size_secret,1,fptr)!=1)
+    {
+        fclose(fptr);
+        return e_failure;
+    }
+    fclose(fptr);
+
+    if(updInfo->patch_offset>updInfo->header.size_file) // A patch may extend the secret, not leave a hole
+    {
+        print_error("\n......Patch offset is beyond the end of the secret......❌\n");
+        return e_failure;
+    }
+    return e_success;
+}
+
+// Function to rewrite only the carrier bytes of secret bytes that changed, a shorter new secret leaves random bytes after it
+Status update_secret_file_data(UpdateInfo *updInfo)
+{
+    long start=(updInfo->patch_offset<0) ? 0 : updInfo->patch_offset; // First secret byte to compare
+    long count=updInfo->size_secret;
+    long old_size=updInfo->header.size_file;
+    long stale=(updInfo->patch_offset<0 && old_size>count) ? old_size-count : 0; // Old secret bytes past the new end
+    off_t base=BMP_HEADER_SIZE+STEGO_HEADER_SIZE+start*8; // Carrier bytes of the first compared byte
+
+    char *carrier=malloc((count+stale)*8+stale);
+    char *noise=carrier+(count+stale)*8; // Replaces the stale bytes, so the old secret cannot be read back
+    if(carrier==NULL || read_full_at(updInfo->fd_stego_image,carrier,(count+stale)*8,base)!=e_success ||
+       getrandom(noise,stale,0)!=stale)
+    {
+        free(carrier);
+        return e_failure;
+    }
+
+    long run_start=-1; // First byte of the current run of changed bytes
+    updInfo->changed_bytes=0;
+    updInfo->written_bytes=0;
+    for(long i=0;i<=count+stale;i++)
+    {
+        int changed=0;
+        if(i<count && (start+i>=old_size || decode_byte_from_lsb(carrier+i*8)!=updInfo->secret_data[i]))
+        {
+            encode_byte_to_lsb(updInfo->secret_data[i],carrier+i*8); // Re-encode only this byte
+            changed=1;
+            updInfo->changed_bytes++;
+        }
+        else if(i>=count && i<count+stale)
+        {
+            encode_byte_to_lsb(noise[i-count],carrier+i*8);
+            changed=1;
+        }
+        if(changed && run_start<0)
+            run_start=i;
+        else if(!changed && run_start>=0) // Flush the run with one pwrite
+        {
+            if(write_full_at(updInfo->fd_stego_image,carrier+run_start*8,(i-run_start)*8,base+run_start*8)!=e_success)
+            {
+                free(carrier);
+                return e_failure;
+            }
+            updInfo->written_bytes+=(i-run_start)*8;
+            run_start=-1;
+        }
+    }
+    free(carrier);
+    return e_success;
+}
+
+// Function to rewrite the secret file size when it changed
+Status update_secret_file_size(UpdateInfo *updInfo)
+{
+    long new_size=updInfo->size_secret;
+    if(updInfo->patch_offset>=0) // A patch only grows the secret when it runs past its end
+        new_size=updInfo->patch_offset+updInfo->size_secret>updInfo->header.size_file ? updInfo->patch_offset+updInfo->size_secret : updInfo->header.size_file;
+    if(new_size==updInfo->header.size_file)
+        return e_success;
+
+    char arr[32];
+    off_t pos=BMP_HEADER_SIZE+STEGO_HEADER_SIZE-32; // Size is the last field of the stego header
+    if(read_full_at(updInfo->fd_stego_image,arr,32,pos)!=e_success)
+        return e_failure;
+    encode_size_to_lsb(new_size,arr); // Encode size into LSB
+    if(write_full_at(updInfo->fd_stego_image,arr,32,pos)!=e_success)
+        return e_failure;
+    updInfo->written_bytes+=32;
+    updInfo->header.size_file=new_size;
+    return e_success;
+}
+
+// Function to rewrite the extension size and extension when the new secret has another extension
+Status update_secret_file_extn(UpdateInfo *updInfo)
+{
+    if(updInfo->patch_offset>=0) // A patch keeps the extension
+        return e_success;
+    char extn[STEGO_EXTN_SIZE+1]={0};
+    strcpy(extn,get_fname_extn(updInfo->secret_fname)); // .txt or .c, checked by read_and_validate_update_args
+    if(strcmp(extn,updInfo->header.ext_secret_file)==0 && updInfo->header.size_ext==(int)strlen(extn))
+        return e_success;
+
+    char arr[32+8*STEGO_EXTN_SIZE];
+    off_t pos=BMP_HEADER_SIZE+STEGO_HEADER_SIZE-32-sizeof(arr); // Extn size and extn come before the file size
+    if(read_full_at(updInfo->fd_stego_image,arr,sizeof(arr),pos)!=e_success)
+        return e_failure;
+    encode_size_to_lsb(strlen(extn),arr); // No flags, protected secrets are not updated
+    for(int i=0;i<STEGO_EXTN_SIZE;i++)
+        encode_byte_to_lsb(extn[i],arr+32+8*i);
+    if(write_full_at(updInfo->fd_stego_image,arr,sizeof(arr),pos)!=e_success)
+        return e_failure;
+    updInfo->written_bytes+=sizeof(arr);
+    updInfo->header.size_ext=strlen(extn);
+    memcpy(updInfo->header.ext_secret_file,extn,sizeof(extn));
+    return e_success;
+}
+
+// Function to perform the update process
+Status do_update(UpdateInfo *updInfo)
+{
+    Status ret=e_failure;
+    updInfo->secret_data=NULL;
+
+    // Open stego image and decode the current header
+    if(open_stego_for_update(updInfo)!=e_success)
+    {
+        print_error("\n****************  ERROR : NOT A STEGO IMAGE *************❌\n");
+        goto out;
+    }
+    if(updInfo->header.flags!=0) // ECC parity would change all over the image, reusing the keystream would leak the secret
+    {
+        print_error("\n......Secret is protected by ECC or encrypted, encode it again instead of updating......❌\n");
+        goto out;
+    }
+    print_status("\n>>>>>> CURRENT SECRET : %d BYTES, EXTENSION %s <<<<<<<✅\n",updInfo->header.size_file,updInfo->header.ext_secret_file);
+
+    // Read the new secret or patch
+    if(read_update_secret(updInfo)!=e_success)
+    {
+        print_error("\n.............New secret file could not be read..................❌\n");
+        goto out;
+    }
+
+    // Check if the image has enough capacity for the updated secret
+    long end=(updInfo->patch_offset<0 ? 0 : updInfo->patch_offset)+updInfo->size_secret;
+    if(get_stego_payload_span(end)>updInfo->image_capacity || BMP_HEADER_SIZE+get_stego_payload_span(end)>updInfo->image_size)
+    {
+        print_error("......Stego image having the less capacity......❌\n");
+        goto out;
+    }
+
+    if(update_secret_file_data(updInfo)!=e_success || update_secret_file_size(updInfo)!=e_success || update_secret_file_extn(updInfo)!=e_success)
+    {
+        print_error("\n.............Secret file data not updated..................❌\n");
+        goto out;
+    }
+    print_status("\n >>>>>>>>>> %ld SECRET BYTES CHANGED, %ld IMAGE BYTES REWRITTEN <<<<<<<<<<<<✅\n",updInfo->changed_bytes,updInfo->written_bytes);
+    ret=e_success;
+out:
+    free(updInfo->secret_data);
+    if(updInfo->fd_stego_image>=0)
+        close(updInfo->fd_stego_image);
+    return ret;
+}
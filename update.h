@@ -0,0 +1,56 @@
+#ifndef UPDATE_H
+#define UPDATE_H
+
+#include "types.h"
+#include "decode.h"
+
+/*
+ * Structure to store information required for
+ * updating the secret of an existing stego image
+ * in place
+ */
+
+typedef struct _UpdateInfo
+{
+    /* Stego Image info, opened read-write */
+    char *stego_image_fname;
+    int fd_stego_image;
+    long image_size;
+    uint image_capacity;
+    DecodeInfo header;
+
+    /* New secret or patch */
+    char *secret_fname;
+    char *secret_data;
+    long size_secret;
+    long patch_offset; // -1 replaces the whole secret
+
+    /* Result */
+    long changed_bytes;
+    long written_bytes;
+} UpdateInfo;
+
+/* Update function prototype */
+
+/* Read and validate the stego, secret and optional offset arguments */
+Status read_and_validate_update_args(char *files[], UpdateInfo *updInfo);
+
+/* Perform the update */
+Status do_update(UpdateInfo *updInfo);
+
+/* Open stego image read-write and decode its current header */
+Status open_stego_for_update(UpdateInfo *updInfo);
+
+/* Read the new secret or patch */
+Status read_update_secret(UpdateInfo *updInfo);
+
+/* Rewrite only the carrier bytes of secret bytes that changed */
+Status update_secret_file_data(UpdateInfo *updInfo);
+
+/* Rewrite the secret file size when it changed */
+Status update_secret_file_size(UpdateInfo *updInfo);
+
+/* Rewrite the extension when a new secret has another one */
+Status update_secret_file_extn(UpdateInfo *updInfo);
+
+#endif